@@ -0,0 +1,1362 @@
+#include "ProofChecker.h"
+
+namespace ProofChecker {
+
+enum {
+	STEP_EXPAND,
+	STEP_AXIOM,
+	STEP_UNIFY,
+	STEP_OPEN
+};
+
+// entries of a model table
+enum {MAX_TABLE = 1 << 24};
+
+static bool IsTerm(int kind) {return kind == N_VAR || kind == N_UVAR || kind == N_FN;}
+
+static void SortUnique(Vector<int>& v) {
+	Sort(v);
+	int j = 0;
+	for(int i = 0; i < v.GetCount(); i++)
+		if (!j || v[j - 1] != v[i])
+			v[j++] = v[i];
+	v.Trim(j);
+}
+
+static bool Has(const Vector<int>& sorted, int x) {
+	int lo = 0, hi = sorted.GetCount();
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (sorted[mid] < x)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < sorted.GetCount() && sorted[lo] == x;
+}
+
+static bool IsSame(const Vector<int>& a, const Vector<int>& b) {
+	if (a.GetCount() != b.GetCount())
+		return false;
+	for(int i = 0; i < a.GetCount(); i++)
+		if (a[i] != b[i])
+			return false;
+	return true;
+}
+
+// set - remove + add
+static Vector<int> Edit(const Vector<int>& set, int remove, int add0 = -1, int add1 = -1) {
+	Vector<int> v;
+	for(int i = 0; i < set.GetCount(); i++)
+		if (set[i] != remove)
+			v.Add(set[i]);
+	if (add0 >= 0) v.Add(add0);
+	if (add1 >= 0) v.Add(add1);
+	SortUnique(v);
+	return v;
+}
+
+static int64 GetOccurrence(int seq, int parent) {
+	return ((int64)seq << 32) | (int64)(uint32)(parent + 1);
+}
+
+static int64 GetLiteralKey(int copy, int lit) {
+	return ((int64)copy << 32) | (int64)(uint32)lit;
+}
+
+
+// Reading
+
+bool CertificateChecker::IsEol() const {
+	const char* p = s;
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+	return p >= end || *p == '\n';
+}
+
+String CertificateChecker::ReadWord() {
+	while (s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+		s++;
+	const char* begin = s;
+	while (s < end && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n')
+		s++;
+	if (begin == s)
+		Fail("Unexpected end of line");
+	return String(begin, (int)(s - begin));
+}
+
+int CertificateChecker::ReadInt() {
+	String w = ReadWord();
+	const char* p = w.Begin();
+	bool negative = *p == '-';
+	if (negative)
+		p++;
+	if (!*p) {
+		Fail("Number expected");
+		return 0;
+	}
+	int value = 0;
+	for(; *p; p++) {
+		if (*p < '0' || *p > '9') {
+			Fail("Number expected: " + w);
+			return 0;
+		}
+		value = value * 10 + (*p - '0');
+	}
+	return negative ? -value : value;
+}
+
+void CertificateChecker::NextLine() {
+	while (s < end && *s != '\n')
+		s++;
+	if (s < end)
+		s++;
+}
+
+int CertificateChecker::MakeNode(int kind, int name, const Vector<int>& a) {
+	String key;
+	key << kind << ' ' << name;
+	for(int i = 0; i < a.GetCount(); i++)
+		key << ' ' << a[i];
+
+	int i = table.Find(key);
+	if (i != -1)
+		return table[i];
+
+	CheckNode& n = nodes.Add();
+	n.kind = kind;
+	n.name = name;
+	n.first = args.GetCount();
+	n.count = a.GetCount();
+	args.Append(a);
+	table.Add(key, nodes.GetCount() - 1);
+	return nodes.GetCount() - 1;
+}
+
+int CertificateChecker::ReadNode() {
+	static const char* kinds[] = {"var", "uvar", "fn", "pred", "not", "and", "or", "imp", "all", "ex"};
+	String w = ReadWord();
+	int kind = -1;
+	for(int i = 0; i < 10; i++)
+		if (w == kinds[i])
+			kind = i;
+	if (kind < 0) {
+		Fail("Unknown node kind: " + w);
+		return -1;
+	}
+
+	int name = -1;
+	int count = 0;
+	if (kind == N_VAR || kind == N_UVAR)
+		name = names.FindAdd(ReadWord());
+	else if (kind == N_FN || kind == N_PRED) {
+		name = names.FindAdd(ReadWord());
+		count = ReadInt();
+	}
+	else if (kind == N_NOT)
+		count = 1;
+	else
+		count = 2;
+
+	Vector<int> a;
+	for(int i = 0; i < count && error.IsEmpty(); i++) {
+		int id = ReadInt();
+		if (id < 0 || id >= ids.GetCount()) {
+			Fail(Format("Undefined node %d", id));
+			return -1;
+		}
+		a.Add(ids[id]);
+	}
+	if (!error.IsEmpty())
+		return -1;
+
+	for(int i = 0; i < a.GetCount(); i++) {
+		int k = nodes[a[i]].kind;
+		bool term_expected = kind == N_FN || kind == N_PRED;
+		bool var_expected = (kind == N_ALL || kind == N_EX) && i == 0;
+		if (var_expected ? k != N_VAR : term_expected != IsTerm(k)) {
+			Fail(Format("Invalid argument for node %d", ids.GetCount()));
+			return -1;
+		}
+	}
+
+	return MakeNode(kind, name, a);
+}
+
+int CertificateChecker::ReadSequent() {
+	for(int side = 0; side < 2; side++) {
+		Vector<int>& v = side == 0 ? left.Add() : right.Add();
+		int count = ReadInt();
+		for(int i = 0; i < count && error.IsEmpty(); i++) {
+			int id = ReadInt();
+			if (id < 0 || id >= ids.GetCount() || IsTerm(nodes[ids[id]].kind))
+				return Fail(Format("Invalid formula %d in sequent", id));
+			v.Add(ids[id]);
+		}
+		SortUnique(v);
+	}
+	return error.IsEmpty();
+}
+
+
+// Terms and formulas
+
+int CertificateChecker::Substitute(int node, int uvar, int value, VectorMap<int, int>& memo) {
+	if (node == uvar)
+		return value;
+	if (nodes[node].count == 0)
+		return node;
+
+	int i = memo.Find(node);
+	if (i != -1)
+		return memo[i];
+
+	Vector<int> a;
+	for(int j = 0; j < nodes[node].count; j++)
+		a.Add(Substitute(GetArg(node, j), uvar, value, memo));
+	int out = MakeNode(nodes[node].kind, nodes[node].name, a);
+	memo.Add(node, out);
+	return out;
+}
+
+// is 'inst' the body with the variable replaced by some term, which is not
+// captured by a quantifier of the body
+bool CertificateChecker::Match(int body, int var, int inst, int& term) const {
+	Vector<int> bound;
+	return Match(body, var, inst, term, bound);
+}
+
+bool CertificateChecker::Match(int body, int var, int inst, int& term, Vector<int>& bound) const {
+	if (body == var) {
+		if (!IsTerm(nodes[inst].kind))
+			return false;
+		if (term < 0)
+			term = inst;
+		if (term != inst)
+			return false;
+		if (bound.IsEmpty())
+			return true;
+		Vector<int> none;
+		Index<int> free;
+		GetFreeNames(inst, none, free);
+		for(int i = 0; i < bound.GetCount(); i++)
+			if (free.Find(bound[i]) != -1)
+				return false;
+		return true;
+	}
+
+	const CheckNode& b = nodes[body];
+	const CheckNode& n = nodes[inst];
+	if (b.count == 0 || b.kind != n.kind || b.name != n.name || b.count != n.count)
+		return body == inst;
+
+	if (b.kind == N_ALL || b.kind == N_EX) {
+		// the variable is shadowed
+		if (GetArg(body, 0) == var)
+			return body == inst;
+		if (GetArg(body, 0) != GetArg(inst, 0))
+			return false;
+		bound.Add(GetArg(body, 0));
+		bool ok = Match(GetArg(body, 1), var, GetArg(inst, 1), term, bound);
+		bound.Drop();
+		return ok;
+	}
+
+	for(int i = 0; i < b.count; i++)
+		if (!Match(GetArg(body, i), var, GetArg(inst, i), term, bound))
+			return false;
+	return true;
+}
+
+void CertificateChecker::GetFreeNames(int node, Vector<int>& bound, Index<int>& out) const {
+	const CheckNode& n = nodes[node];
+	if (n.kind == N_VAR || n.kind == N_UVAR) {
+		for(int i = 0; i < bound.GetCount(); i++)
+			if (bound[i] == node)
+				return;
+		out.FindAdd(node);
+		return;
+	}
+
+	if (n.kind == N_ALL || n.kind == N_EX) {
+		bound.Add(GetArg(node, 0));
+		GetFreeNames(GetArg(node, 1), bound, out);
+		bound.Drop();
+		return;
+	}
+
+	for(int i = 0; i < n.count; i++)
+		GetFreeNames(GetArg(node, i), bound, out);
+}
+
+void CertificateChecker::GetFreeNames(const Vector<int>& formulas, Index<int>& out) const {
+	Vector<int> bound;
+	for(int i = 0; i < formulas.GetCount(); i++)
+		GetFreeNames(formulas[i], bound, out);
+}
+
+
+// Sequent proofs
+
+bool CertificateChecker::IsChild(int step, int seq) const {
+	const CheckStep& st = steps[step];
+	if (st.kind != STEP_EXPAND)
+		return false;
+	for(int i = 0; i < st.count; i++)
+		if (refs[st.first + i] == seq)
+			return true;
+	return false;
+}
+
+bool CertificateChecker::CheckInstances(const Vector<int>& parent, const Vector<int>& child, int body, int var) {
+	for(int i = 0; i < parent.GetCount(); i++)
+		if (!Has(child, parent[i]))
+			return Fail("Formula lost by a quantifier rule");
+
+	for(int i = 0; i < child.GetCount(); i++) {
+		if (Has(parent, child[i]))
+			continue;
+		int term = -1;
+		if (!Match(body, var, child[i], term))
+			return Fail("Formula is not an instance of the quantified formula");
+	}
+	return true;
+}
+
+bool CertificateChecker::CheckEigen(int seq, const Vector<int>& parent, const Vector<int>& child, int principal, int body, int var) {
+	Vector<int> rest = Edit(parent, principal);
+	int inst = -1;
+	for(int i = 0; i < child.GetCount(); i++) {
+		if (Has(rest, child[i]))
+			continue;
+		if (inst >= 0)
+			return Fail("More than one new formula");
+		inst = child[i];
+	}
+	if (inst < 0 || child.GetCount() != rest.GetCount() + 1)
+		return Fail("Invalid eigenvariable rule");
+
+	int term = -1;
+	if (!Match(body, var, inst, term))
+		return Fail("Formula is not an instance of the quantified formula");
+	if (term < 0)
+		return true;
+
+	if (nodes[term].kind != N_VAR)
+		return Fail("Eigenvariable is not a variable");
+
+	Index<int> free;
+	GetFreeNames(left[seq], free);
+	GetFreeNames(right[seq], free);
+	if (free.Find(term) != -1)
+		return Fail("Eigenvariable is not fresh");
+	return true;
+}
+
+bool CertificateChecker::CheckRule(int step) {
+	const CheckStep& st = steps[step];
+	const Vector<int>& l = left[st.seq];
+	const Vector<int>& r = right[st.seq];
+	int p = st.principal;
+	bool on_left = st.side == 0;
+
+	if (!Has(on_left ? l : r, p))
+		return Fail("Principal formula is not in the sequent");
+
+	const CheckNode& n = nodes[p];
+	int expected = (n.kind == N_OR && on_left) || (n.kind == N_IMP && on_left) || (n.kind == N_AND && !on_left) ? 2 : 1;
+	if (n.kind == N_PRED)
+		return Fail("No rule for an atom");
+	if (st.count != expected)
+		return Fail("Wrong number of premises");
+
+	int a = n.count > 0 ? GetArg(p, 0) : -1;
+	int b = n.count > 1 ? GetArg(p, 1) : -1;
+	int c0 = refs[st.first];
+	int c1 = expected > 1 ? refs[st.first + 1] : -1;
+	bool ok = true;
+
+	if (on_left) {
+		switch (n.kind) {
+		case N_NOT: ok = IsSame(left[c0], Edit(l, p)) && IsSame(right[c0], Edit(r, -1, a)); break;
+		case N_AND: ok = IsSame(left[c0], Edit(l, p, a, b)) && IsSame(right[c0], r); break;
+		case N_OR:  ok = IsSame(left[c0], Edit(l, p, a)) && IsSame(right[c0], r) &&
+		                 IsSame(left[c1], Edit(l, p, b)) && IsSame(right[c1], r); break;
+		case N_IMP: ok = IsSame(left[c0], Edit(l, p)) && IsSame(right[c0], Edit(r, -1, a)) &&
+		                 IsSame(left[c1], Edit(l, p, b)) && IsSame(right[c1], r); break;
+		case N_ALL: return IsSame(right[c0], r) ? CheckInstances(l, left[c0], b, a) : Fail("∀L changed the right side");
+		case N_EX:  return IsSame(right[c0], r) ? CheckEigen(st.seq, l, left[c0], p, b, a) : Fail("∃L changed the right side");
+		}
+	}
+	else {
+		switch (n.kind) {
+		case N_NOT: ok = IsSame(left[c0], Edit(l, -1, a)) && IsSame(right[c0], Edit(r, p)); break;
+		case N_AND: ok = IsSame(left[c0], l) && IsSame(right[c0], Edit(r, p, a)) &&
+		                 IsSame(left[c1], l) && IsSame(right[c1], Edit(r, p, b)); break;
+		case N_OR:  ok = IsSame(left[c0], l) && IsSame(right[c0], Edit(r, p, a, b)); break;
+		case N_IMP: ok = IsSame(left[c0], Edit(l, -1, a)) && IsSame(right[c0], Edit(r, p, b)); break;
+		case N_ALL: return IsSame(left[c0], l) ? CheckEigen(st.seq, r, right[c0], p, b, a) : Fail("∀R changed the left side");
+		case N_EX:  return IsSame(left[c0], l) ? CheckInstances(r, right[c0], b, a) : Fail("∃R changed the left side");
+		}
+	}
+
+	return ok ? true : Fail(Format("Invalid rule application in step %d", step));
+}
+
+int CertificateChecker::FindIntro(int step, int name) const {
+	while (step >= 0) {
+		const CheckStep& st = steps[step];
+		for(int i = 0; i < st.intro_count; i++)
+			if (intros[st.first_intro + i] == name)
+				return st.first_intro + i;
+		step = st.parent;
+	}
+	return -1;
+}
+
+// a unification term depends on the names of its value, an eigenvariable on the
+// unification terms of the formulas it was introduced for
+void CertificateChecker::GetDependencies(int name, const VectorMap<int, int>& bound,
+                                         const VectorMap<int, Vector<int> >& introduced, Index<int>& out) const {
+	Vector<int> tmp;
+	int i = bound.Find(name);
+	if (i != -1)
+		GetFreeNames(bound[i], tmp, out);
+	else if ((i = introduced.Find(name)) != -1)
+		GetFreeNames(introduced[i], out);
+}
+
+// one depth first search over the dependencies: grey names are on the current
+// path, so reaching one again is a cycle, black ones are done
+bool CertificateChecker::CheckAcyclic(const VectorMap<int, int>& values) {
+	enum {GREY = 1, BLACK = 2};
+
+	VectorMap<int, int> bound;
+	for(int i = 0; i < values.GetCount(); i++)
+		bound.GetAdd(intros[values.GetKey(i)], values[i]);
+
+	VectorMap<int, Vector<int> > introduced;
+	for(int i = 0; i < intros.GetCount(); i++)
+		if (nodes[intros[i]].kind == N_VAR)
+			introduced.GetAdd(intros[i]).Add(steps[intro_steps[i]].principal);
+
+	struct Visit : Moveable<Visit> {
+		int name;
+		int next;
+	};
+	VectorMap<int, int> colour;
+	Vector<Index<int> > edges;
+	Vector<Visit> stack;
+
+	for(int i = 0; i < bound.GetCount(); i++) {
+		if (colour.Find(bound.GetKey(i)) != -1)
+			continue;
+		colour.Add(bound.GetKey(i), GREY);
+		stack.Add().name = bound.GetKey(i);
+		stack.Top().next = 0;
+		GetDependencies(bound.GetKey(i), bound, introduced, edges.Add());
+
+		while (!stack.IsEmpty()) {
+			Visit& v = stack.Top();
+			const Index<int>& e = edges.Top();
+			if (v.next >= e.GetCount()) {
+				colour.Get(v.name) = BLACK;
+				stack.Drop();
+				edges.Drop();
+				continue;
+			}
+
+			int name = e[v.next++];
+			int c = colour.Find(name);
+			if (c != -1) {
+				if (colour[c] == GREY)
+					return Fail("Unifier depends on itself through an eigenvariable");
+				continue;
+			}
+			colour.Add(name, GREY);
+			Index<int> next;
+			GetDependencies(name, bound, introduced, next);
+			stack.Add().name = name;
+			stack.Top().next = 0;
+			edges.Add(pick(next));
+		}
+	}
+	return true;
+}
+
+bool CertificateChecker::CheckUnify(int step, VectorMap<int, int>& values, Index<int64>& closed) {
+	const CheckStep& st = steps[step];
+	Vector<VectorMap<int, int> > memo;
+	memo.SetCount(st.count);
+
+	for(int i = 0; i < st.closed_count; i++) {
+		int seq = refs[st.first_closed + 2 * i];
+		int parent = refs[st.first_closed + 2 * i + 1];
+		if (parent < 0 ? seq != steps[0].seq : (parent >= step || !IsChild(parent, seq)))
+			return Fail(Format("Invalid sibling in step %d", step));
+
+		// the substitution is applied to atoms only, so nothing can be captured
+		Vector<int> atoms[2];
+		for(int side = 0; side < 2; side++) {
+			const Vector<int>& v = side == 0 ? left[seq] : right[seq];
+			for(int j = 0; j < v.GetCount(); j++) {
+				if (nodes[v[j]].kind != N_PRED)
+					continue;
+				int atom = v[j];
+				for(int k = 0; k < st.count; k++)
+					atom = Substitute(atom, refs[st.first + 2 * k], refs[st.first + 2 * k + 1], memo[k]);
+				atoms[side].Add(atom);
+			}
+			SortUnique(atoms[side]);
+		}
+
+		bool found = false;
+		for(int j = 0; j < atoms[0].GetCount() && !found; j++)
+			found = Has(atoms[1], atoms[0][j]);
+		if (!found)
+			return Fail(Format("Sequent %d is not closed by the unifier of step %d", seq, step));
+
+		for(int k = 0; k < st.count; k++) {
+			int intro = FindIntro(parent, refs[st.first + 2 * k]);
+			if (intro < 0)
+				continue;
+
+			int value = refs[st.first + 2 * k + 1];
+			int j = values.Find(intro);
+			if (j == -1)
+				values.Add(intro, value);
+			else if (values[j] != value)
+				return Fail(Format("Unification term bound to different values in step %d", step));
+		}
+
+		closed.FindAdd(GetOccurrence(seq, parent));
+	}
+	return true;
+}
+
+bool CertificateChecker::CheckSequentProof() {
+	if (steps.IsEmpty())
+		return Fail("No proof steps");
+
+	const CheckStep& root = steps[0];
+	Vector<int> axiom_set;
+	axiom_set <<= axioms;
+	SortUnique(axiom_set);
+	Vector<int> goal_set;
+	goal_set.Add(goal);
+	if (root.parent != -1 || !IsSame(left[root.seq], axiom_set) || !IsSame(right[root.seq], goal_set))
+		return Fail("The first step is not the goal sequent");
+
+	Index<int64> closed;
+	Index<int> axiom_closed;
+	VectorMap<int, int> values;
+
+	for(int i = 0; i < steps.GetCount(); i++) {
+		CheckStep& st = steps[i];
+		if (i > 0 && (st.parent < 0 || st.parent >= i || !IsChild(st.parent, st.seq)))
+			return Fail(Format("Step %d is not a premise of its parent", i));
+
+		st.first_intro = intros.GetCount();
+		st.intro_count = 0;
+
+		if (st.kind == STEP_EXPAND) {
+			if (!CheckRule(i))
+				return false;
+
+			// names which occur in the premises but not in the conclusion
+			Index<int> before, after;
+			GetFreeNames(left[st.seq], before);
+			GetFreeNames(right[st.seq], before);
+			for(int j = 0; j < st.count; j++) {
+				GetFreeNames(left[refs[st.first + j]], after);
+				GetFreeNames(right[refs[st.first + j]], after);
+			}
+			for(int j = 0; j < after.GetCount(); j++) {
+				if (before.Find(after[j]) == -1) {
+					intros.Add(after[j]);
+					intro_steps.Add(i);
+					st.intro_count++;
+				}
+			}
+		}
+		else if (st.kind == STEP_AXIOM) {
+			bool found = false;
+			const Vector<int>& l = left[st.seq];
+			for(int j = 0; j < l.GetCount() && !found; j++)
+				found = Has(right[st.seq], l[j]);
+			if (!found)
+				return Fail(Format("Step %d is not an axiom", i));
+			axiom_closed.FindAdd(st.seq);
+			closed.FindAdd(GetOccurrence(st.seq, st.parent));
+		}
+		else if (st.kind == STEP_UNIFY) {
+			if (!CheckUnify(i, values, closed))
+				return false;
+		}
+	}
+
+	// premises are proven before their conclusions
+	for(int i = steps.GetCount() - 1; i >= 0; i--) {
+		const CheckStep& st = steps[i];
+		if (st.kind != STEP_EXPAND)
+			continue;
+		bool all = true;
+		for(int j = 0; j < st.count && all; j++) {
+			int seq = refs[st.first + j];
+			all = closed.Find(GetOccurrence(seq, i)) != -1 || axiom_closed.Find(seq) != -1;
+		}
+		if (all)
+			closed.FindAdd(GetOccurrence(st.seq, st.parent));
+	}
+
+	if (closed.Find(GetOccurrence(root.seq, -1)) == -1)
+		return Fail("The goal sequent is not closed");
+	return CheckAcyclic(values);
+}
+
+
+// Connection proofs
+
+int CertificateChecker::ReadLiteral() {
+	String w = ReadWord();
+	if (w.GetCount() < 2 || (w[0] != '+' && w[0] != '-')) {
+		Fail("Literal expected: " + w);
+		return -1;
+	}
+	int id = 0;
+	for(int i = 1; i < w.GetCount(); i++) {
+		if (w[i] < '0' || w[i] > '9') {
+			Fail("Literal expected: " + w);
+			return -1;
+		}
+		id = id * 10 + (w[i] - '0');
+	}
+	if (id >= ids.GetCount() || nodes[ids[id]].kind != N_PRED) {
+		Fail(Format("Invalid atom %d", id));
+		return -1;
+	}
+	return ids[id] * 2 + (w[0] == '-');
+}
+
+// The clausification of the prover: negation normal form, skolemization and
+// distribution, where a disjunction which would give more than DEFINITION_LIMIT
+// clauses gets a definition over the variables of its larger side. The clause
+// variables are named _V<n> here, and _X<n> in the order of their first
+// occurrence in each clause.
+
+enum {
+	NNF_LITERAL,
+	NNF_AND,
+	NNF_OR
+};
+
+enum {DEFINITION_LIMIT = 64};
+
+int CertificateChecker::AddNnf(int kind, int atom, bool negative, int a, int b) {
+	CheckNnf& n = nnf.Add();
+	n.kind = kind;
+	n.atom = atom;
+	n.negative = negative;
+	n.a = a;
+	n.b = b;
+	int64 count = kind == NNF_LITERAL ? 1 :
+	              kind == NNF_AND ? (int64)clause_count[a] + clause_count[b] :
+	              (int64)clause_count[a] * clause_count[b];
+	clause_count.Add((int)min(count, (int64)DEFINITION_LIMIT + 1));
+	return nnf.GetCount() - 1;
+}
+
+int CertificateChecker::MakeTerm(int node) {
+	CheckNode n = nodes[node];  // a copy, MakeNode adds nodes
+	if (n.kind == N_VAR) {
+		for(int i = scope_vars.GetCount() - 1; i >= 0; i--)
+			if (scope_vars[i] == node)
+				return scope_terms[i];
+
+		// free variable: a constant
+		return MakeNode(N_FN, n.name, Vector<int>());
+	}
+	if (n.kind == N_UVAR)
+		return Fail("Unification term in a formula"), -1;
+
+	// the names of the prover's Skolem functions and definitions are reserved
+	const String& name = names[n.name];
+	if (name.StartsWith("_sk") || name.StartsWith("_def"))
+		return Fail("Reserved name: " + name), -1;
+
+	Vector<int> a;
+	for(int i = 0; i < n.count; i++) {
+		int t = MakeTerm(GetArg(node, i));
+		if (t < 0)
+			return -1;
+		a.Add(t);
+	}
+	return MakeNode(n.kind, n.name, a);
+}
+
+int CertificateChecker::Nnf(int node, bool positive) {
+	CheckNode n = nodes[node];  // a copy, MakeNode adds nodes
+	int a, b;
+
+	switch (n.kind) {
+	case N_PRED:
+		a = MakeTerm(node);
+		return a < 0 ? -1 : AddNnf(NNF_LITERAL, a, !positive, -1, -1);
+	case N_NOT:
+		return Nnf(GetArg(node, 0), !positive);
+	case N_AND:
+	case N_OR:
+	case N_IMP:
+		a = Nnf(GetArg(node, 0), n.kind == N_IMP ? !positive : positive);
+		b = a < 0 ? -1 : Nnf(GetArg(node, 1), positive);
+		if (b < 0)
+			return -1;
+		return AddNnf((n.kind == N_AND) == positive ? NNF_AND : NNF_OR, -1, false, a, b);
+	case N_ALL:
+	case N_EX: {
+		bool universal_var = (n.kind == N_ALL) == positive;
+		int term;
+		if (universal_var) {
+			term = MakeNode(N_VAR, names.FindAdd("_V" + IntStr(var_counter++)), Vector<int>());
+			universal.Add(term);
+		}
+		else
+			term = MakeNode(N_FN, names.FindAdd("_sk" + IntStr(++skolem_counter)), universal);
+
+		scope_vars.Add(GetArg(node, 0));
+		scope_terms.Add(term);
+		a = Nnf(GetArg(node, 1), positive);
+		scope_vars.Drop();
+		scope_terms.Drop();
+
+		if (universal_var)
+			universal.Drop();
+		return a;
+	}
+	}
+	return Fail("Term where a formula is expected"), -1;
+}
+
+void CertificateChecker::Cnf(int node, Vector<Vector<int> >& out) {
+	CheckNnf n = nnf[node];  // a copy, Define adds nodes
+
+	if (n.kind == NNF_LITERAL) {
+		out.Add().Add(n.atom * 2 + n.negative);
+		return;
+	}
+
+	if (n.kind == NNF_AND) {
+		Cnf(n.a, out);
+		Cnf(n.b, out);
+		return;
+	}
+
+	int na = n.a, nb = n.b;
+	if (clause_count[na] < clause_count[nb])
+		Swap(na, nb);
+	if (clause_count[na] * clause_count[nb] > DEFINITION_LIMIT)
+		na = Define(na);
+	if (clause_count[na] * clause_count[nb] > DEFINITION_LIMIT)
+		nb = Define(nb);
+
+	Vector<Vector<int> > a, b;
+	Cnf(na, a);
+	Cnf(nb, b);
+	for(int i = 0; i < a.GetCount(); i++) {
+		for(int j = 0; j < b.GetCount(); j++) {
+			Vector<int>& c = out.Add();
+			c.Append(a[i]);
+			c.Append(b[j]);
+		}
+	}
+}
+
+int CertificateChecker::Define(int node) {
+	Index<int> vars;
+	GetNnfVariables(node, vars);
+	int atom = MakeNode(N_PRED, names.FindAdd("_def" + IntStr(++definition_counter)), vars.PickKeys());
+
+	Vector<Vector<int> > cnf;
+	Cnf(node, cnf);
+	for(int i = 0; i < cnf.GetCount(); i++) {
+		Vector<int>& c = definitions.Add();
+		c.Add(atom * 2 + 1);
+		c.Append(cnf[i]);
+	}
+	return AddNnf(NNF_LITERAL, atom, false, -1, -1);
+}
+
+void CertificateChecker::GetVariables(int term, Index<int>& vars) const {
+	const CheckNode& n = nodes[term];
+	if (n.kind == N_VAR) {
+		vars.FindAdd(term);
+		return;
+	}
+	for(int i = 0; i < n.count; i++)
+		GetVariables(GetArg(term, i), vars);
+}
+
+void CertificateChecker::GetNnfVariables(int node, Index<int>& vars) const {
+	const CheckNnf& n = nnf[node];
+	if (n.kind == NNF_LITERAL)
+		GetVariables(n.atom, vars);
+	else {
+		GetNnfVariables(n.a, vars);
+		GetNnfVariables(n.b, vars);
+	}
+}
+
+// replaces the variables by their values at the same time
+int CertificateChecker::Instantiate(int node, const VectorMap<int, int>& values, VectorMap<int, int>& memo) {
+	CheckNode n = nodes[node];  // a copy, MakeNode adds nodes
+	if (n.kind == N_VAR)
+		return values.Get(node, node);
+	if (n.count == 0)
+		return node;
+
+	int i = memo.Find(node);
+	if (i != -1)
+		return memo[i];
+
+	Vector<int> a;
+	for(int j = 0; j < n.count; j++)
+		a.Add(Instantiate(GetArg(node, j), values, memo));
+	int out = MakeNode(n.kind, n.name, a);
+	memo.Add(node, out);
+	return out;
+}
+
+bool CertificateChecker::AddClauses(int formula, bool positive, Vector<Vector<int> >& out) {
+	nnf.Clear();
+	clause_count.Clear();
+	scope_vars.Clear();
+	scope_terms.Clear();
+	universal.Clear();
+	definitions.Clear();
+
+	int root = Nnf(formula, positive);
+	if (root < 0)
+		return false;
+
+	Vector<Vector<int> > cnf;
+	Cnf(root, cnf);
+	cnf.AppendPick(pick(definitions));
+
+	for(int i = 0; i < cnf.GetCount(); i++) {
+		// drop duplicate literals and tautologies
+		Vector<int> unique;
+		bool tautology = false;
+		for(int j = 0; j < cnf[i].GetCount() && !tautology; j++) {
+			int lit = cnf[i][j];
+			bool duplicate = false;
+			for(int k = 0; k < unique.GetCount(); k++) {
+				if (lit == unique[k])
+					duplicate = true;
+				else if ((lit ^ 1) == unique[k])
+					tautology = true;
+			}
+			if (!duplicate)
+				unique.Add(lit);
+		}
+		if (tautology)
+			continue;
+
+		Index<int> vars;
+		for(int j = 0; j < unique.GetCount(); j++)
+			GetVariables(unique[j] / 2, vars);
+		VectorMap<int, int> values, memo;
+		for(int j = 0; j < vars.GetCount(); j++)
+			values.Add(vars[j], MakeNode(N_VAR, names.FindAdd("_X" + IntStr(j)), Vector<int>()));
+
+		Vector<int>& c = out.Add();
+		for(int j = 0; j < unique.GetCount(); j++)
+			c.Add(Instantiate(unique[j] / 2, values, memo) * 2 + (unique[j] & 1));
+	}
+	return true;
+}
+
+bool CertificateChecker::CheckClauses() {
+	var_counter = skolem_counter = definition_counter = 0;
+
+	Vector<Vector<int> > own;
+	for(int i = 0; i < axioms.GetCount(); i++)
+		if (!AddClauses(axioms[i], true, own))
+			return false;
+	if (!AddClauses(goal, false, own))
+		return false;
+
+	if (own.GetCount() != clauses.GetCount())
+		return Fail(Format("The problem has %d clauses, the certificate %d", own.GetCount(), clauses.GetCount()));
+	for(int i = 0; i < own.GetCount(); i++)
+		if (!IsSame(own[i], clauses[i]))
+			return Fail(Format("Clause %d is not a clause of the problem", i));
+	return true;
+}
+
+bool CertificateChecker::CheckConnectionProof() {
+	if (!CheckClauses())
+		return false;
+	if (copies.IsEmpty())
+		return Fail("No clause copies");
+
+	// the literals of the copies under their bindings
+	Vector<Vector<int> > lits;
+	Vector<Vector<int> > child;  // the copy which extends a literal, -1 for none
+	for(int i = 0; i < copies.GetCount(); i++) {
+		const CheckCopy& c = copies[i];
+		if (c.clause < 0 || c.clause >= clauses.GetCount())
+			return Fail(Format("Invalid clause in copy %d", i));
+		const Vector<int>& clause = clauses[c.clause];
+
+		VectorMap<int, int> memo;
+		Vector<int>& l = lits.Add();
+		for(int j = 0; j < clause.GetCount(); j++)
+			l.Add(Instantiate(clause[j] / 2, binds[i], memo) * 2 + (clause[j] & 1));
+		child.Add().SetCount(clause.GetCount(), -1);
+
+		if (i == 0 ? c.parent != -1 || c.entry != -1 : c.parent < 0 || c.parent >= i)
+			return Fail(Format("Invalid parent of copy %d", i));
+		if (i == 0)
+			continue;
+
+		const CheckCopy& p = copies[c.parent];
+		if (c.entry < 0 || c.entry >= clause.GetCount() ||
+		    c.parent_lit < 0 || c.parent_lit >= lits[c.parent].GetCount() || c.parent_lit == p.entry)
+			return Fail(Format("Invalid extension of copy %d", i));
+		if (child[c.parent][c.parent_lit] >= 0)
+			return Fail(Format("Literal %d of copy %d is extended twice", c.parent_lit, c.parent));
+		if ((l[c.entry] ^ 1) != lits[c.parent][c.parent_lit])
+			return Fail(Format("The extension of copy %d is not complementary", i));
+		child[c.parent][c.parent_lit] = i;
+	}
+
+	VectorMap<int64, int> reduced;
+	for(int i = 0; i < reductions.GetCount(); i++) {
+		const CheckReduction& r = reductions[i];
+		if (r.copy < 0 || r.copy >= copies.GetCount() || r.lit < 0 || r.lit >= lits[r.copy].GetCount() ||
+		    r.ancestor < 0 || r.ancestor >= copies.GetCount() || r.ancestor_lit < 0 || r.ancestor_lit >= lits[r.ancestor].GetCount())
+			return Fail(Format("Invalid reduction %d", i));
+		if (child[r.copy][r.lit] >= 0 || reduced.Find(GetLiteralKey(r.copy, r.lit)) != -1)
+			return Fail(Format("Literal %d of copy %d is closed twice", r.lit, r.copy));
+		if ((lits[r.copy][r.lit] ^ 1) != lits[r.ancestor][r.ancestor_lit])
+			return Fail(Format("Reduction %d is not complementary", i));
+		reduced.Add(GetLiteralKey(r.copy, r.lit), i);
+	}
+
+	// Depth first through the tableau: 'path' holds the extended literals above
+	// the current one, 'lemmas' the literals solved before it in its copy and in
+	// its ancestors.
+	struct Visit : Moveable<Visit> {
+		int copy, lit;
+		int lemma_mark;
+	};
+	Index<int64> path;
+	Index<int> lemmas;
+	Vector<Visit> stack;
+	Visit& root = stack.Add();
+	root.copy = 0;
+	root.lit = -1;
+	root.lemma_mark = 0;
+
+	while (!stack.IsEmpty()) {
+		Visit& v = stack.Top();
+		const Vector<int>& l = lits[v.copy];
+		int lit = v.lit + 1;
+		if (lit == copies[v.copy].entry)
+			lit++;
+
+		if (lit >= l.GetCount()) {
+			// the literal extended by this copy is solved
+			lemmas.Trim(v.lemma_mark);
+			stack.Drop();
+			if (!stack.IsEmpty()) {
+				const Visit& p = stack.Top();
+				path.Drop();
+				lemmas.Add(lits[p.copy][p.lit]);
+			}
+			continue;
+		}
+		v.lit = lit;
+
+		int c = child[v.copy][lit];
+		if (c >= 0) {
+			path.Add(GetLiteralKey(v.copy, lit));
+			Visit& next = stack.Add();
+			next.copy = c;
+			next.lit = -1;
+			next.lemma_mark = lemmas.GetCount();
+			continue;
+		}
+
+		int r = reduced.Find(GetLiteralKey(v.copy, lit));
+		if (r != -1) {
+			const CheckReduction& red = reductions[reduced[r]];
+			if (path.Find(GetLiteralKey(red.ancestor, red.ancestor_lit)) == -1)
+				return Fail(Format("Literal %d of copy %d is reduced with a literal off its path", lit, v.copy));
+		}
+		else if (lemmas.Find(l[lit]) == -1)
+			return Fail(Format("Literal %d of copy %d is open", lit, v.copy));
+		lemmas.Add(l[lit]);
+	}
+	return true;
+}
+
+
+// Countermodels
+
+bool CertificateChecker::EvaluateTerm(int node, const Vector<int>& env_vars, const Vector<int>& env_values, int& value) {
+	const CheckNode& n = nodes[node];
+
+	if (n.kind == N_VAR) {
+		for(int i = env_vars.GetCount() - 1; i >= 0; i--) {
+			if (env_vars[i] == node) {
+				value = env_values[i];
+				return true;
+			}
+		}
+	}
+	else if (n.kind != N_FN)
+		return Fail("Unification term in a formula");
+
+	int index = 0, mul = 1;
+	for(int i = 0; i < n.count; i++) {
+		int a;
+		if (!EvaluateTerm(GetArg(node, i), env_vars, env_values, a))
+			return false;
+		index += a * mul;
+		mul *= model_size;
+	}
+
+	int i = model.Find("fn " + names[n.name] + " " + IntStr(n.count));
+	if (i == -1)
+		return Fail("Model has no value for " + names[n.name]);
+	value = model[i][index];
+	return true;
+}
+
+bool CertificateChecker::Evaluate(int node, Vector<int>& env_vars, Vector<int>& env_values, bool& value) {
+	const CheckNode& n = nodes[node];
+	bool a, b;
+
+	switch (n.kind) {
+	case N_PRED: {
+		int index = 0, mul = 1;
+		for(int i = 0; i < n.count; i++) {
+			int e;
+			if (!EvaluateTerm(GetArg(node, i), env_vars, env_values, e))
+				return false;
+			index += e * mul;
+			mul *= model_size;
+		}
+		int i = model.Find("pred " + names[n.name] + " " + IntStr(n.count));
+		if (i == -1)
+			return Fail("Model has no value for " + names[n.name]);
+		value = model[i][index] != 0;
+		return true;
+	}
+	case N_NOT:
+		if (!Evaluate(GetArg(node, 0), env_vars, env_values, a))
+			return false;
+		value = !a;
+		return true;
+	case N_AND:
+	case N_OR:
+	case N_IMP:
+		if (!Evaluate(GetArg(node, 0), env_vars, env_values, a) ||
+			!Evaluate(GetArg(node, 1), env_vars, env_values, b))
+			return false;
+		value = n.kind == N_AND ? a && b : n.kind == N_OR ? a || b : !a || b;
+		return true;
+	case N_ALL:
+	case N_EX:
+		value = n.kind == N_ALL;
+		env_vars.Add(GetArg(node, 0));
+		env_values.Add(0);
+		for(int e = 0; e < model_size; e++) {
+			env_values.Top() = e;
+			if (!Evaluate(GetArg(node, 1), env_vars, env_values, a))
+				return false;
+			if (a != value) {
+				value = a;
+				break;
+			}
+		}
+		env_vars.Drop();
+		env_values.Drop();
+		return true;
+	}
+	return Fail("Term where a formula is expected");
+}
+
+bool CertificateChecker::CheckModel() {
+	if (model_size <= 0)
+		return Fail("Empty domain");
+
+	// the evaluation indexes the tables without checking
+	for(int i = 0; i < model.GetCount(); i++) {
+		const String& key = model.GetKey(i);
+		const Vector<int>& t = model[i];
+		int arity = atoi(key.Mid(key.ReverseFind(' ') + 1));
+		int64 rows = 1;
+		for(int j = 0; j < arity && rows <= MAX_TABLE; j++)
+			rows *= model_size;
+		if (t.GetCount() != rows)
+			return Fail("Wrong size of the table of " + key);
+		int limit = key.StartsWith("fn ") ? model_size : 2;
+		for(int j = 0; j < t.GetCount(); j++)
+			if (t[j] < 0 || t[j] >= limit)
+				return Fail("Invalid value in the table of " + key);
+	}
+
+	Vector<int> env_vars, env_values;
+	bool value;
+	for(int i = 0; i < axioms.GetCount(); i++) {
+		if (!Evaluate(axioms[i], env_vars, env_values, value))
+			return false;
+		if (!value)
+			return Fail("An axiom is false in the model");
+	}
+	if (!Evaluate(goal, env_vars, env_values, value))
+		return false;
+	if (value)
+		return Fail("The goal is true in the model");
+	return true;
+}
+
+
+// Certificates
+
+void CertificateChecker::Reset() {
+	names.Clear();
+	nodes.Clear();
+	args.Clear();
+	table.Clear();
+	ids.Clear();
+	axioms.Clear();
+	goal = -1;
+	left.Clear();
+	right.Clear();
+	steps.Clear();
+	refs.Clear();
+	intros.Clear();
+	intro_steps.Clear();
+	clauses.Clear();
+	copies.Clear();
+	binds.Clear();
+	reductions.Clear();
+	model_size = 0;
+	model.Clear();
+	error.Clear();
+}
+
+int CertificateChecker::Check(const char*& pos, const char* end) {
+	Reset();
+	s = pos;
+	this->end = end;
+
+	String engine, result;
+	bool header = false;
+
+	while (s < end) {
+		if (IsEol()) {
+			NextLine();
+			continue;
+		}
+
+		String w = ReadWord();
+		if (w == "end") {
+			NextLine();
+			break;
+		}
+		if (!error.IsEmpty()) {
+			NextLine();
+			continue;
+		}
+
+		if (!header) {
+			header = true;
+			if (w != "tpcert" || ReadInt() != 1)
+				Fail("Not a certificate");
+		}
+		else if (w == "engine")
+			engine = ReadWord();
+		else if (w == "result")
+			result = ReadWord();
+		else if (w == "n") {
+			if (ReadInt() != ids.GetCount())
+				Fail("Node ids are not consecutive");
+			else
+				ids.Add(ReadNode());
+		}
+		else if (w == "axiom" || w == "goal") {
+			int id = ReadInt();
+			if (id < 0 || id >= ids.GetCount() || IsTerm(nodes[ids[id]].kind))
+				Fail(Format("Invalid formula %d", id));
+			else if (w == "axiom")
+				axioms.Add(ids[id]);
+			else
+				goal = ids[id];
+		}
+		else if (w == "seq") {
+			if (ReadInt() != left.GetCount())
+				Fail("Sequent ids are not consecutive");
+			else
+				ReadSequent();
+		}
+		else if (w == "step") {
+			if (ReadInt() != steps.GetCount())
+				Fail("Step ids are not consecutive");
+			CheckStep& st = steps.Add();
+			st.seq = ReadInt();
+			st.parent = ReadInt();
+			st.side = 0;
+			st.principal = -1;
+			st.first = st.first_closed = refs.GetCount();
+			st.count = st.closed_count = 0;
+			st.first_intro = st.intro_count = 0;
+			if (st.seq < 0 || st.seq >= left.GetCount())
+				Fail("Invalid sequent in step");
+
+			String kind = ReadWord();
+			if (kind == "expand") {
+				st.kind = STEP_EXPAND;
+				String side = ReadWord();
+				st.side = side == "L" ? 0 : 1;
+				int id = ReadInt();
+				if (id < 0 || id >= ids.GetCount())
+					Fail("Invalid principal formula");
+				else
+					st.principal = ids[id];
+				st.count = ReadInt();
+				for(int i = 0; i < st.count && error.IsEmpty(); i++) {
+					int seq = ReadInt();
+					if (seq < 0 || seq >= left.GetCount())
+						Fail("Invalid premise");
+					refs.Add(seq);
+				}
+			}
+			else if (kind == "axiom")
+				st.kind = STEP_AXIOM;
+			else if (kind == "unify") {
+				st.kind = STEP_UNIFY;
+				st.count = ReadInt();
+				for(int i = 0; i < st.count && error.IsEmpty(); i++) {
+					int uvar = ReadInt();
+					int value = ReadInt();
+					if (uvar < 0 || uvar >= ids.GetCount() || nodes[ids[uvar]].kind != N_UVAR ||
+						value < 0 || value >= ids.GetCount() || !IsTerm(nodes[ids[value]].kind))
+						Fail("Invalid unifier");
+					else {
+						refs.Add(ids[uvar]);
+						refs.Add(ids[value]);
+					}
+				}
+				st.first_closed = refs.GetCount();
+				st.closed_count = ReadInt();
+				for(int i = 0; i < st.closed_count && error.IsEmpty(); i++) {
+					int seq = ReadInt();
+					int parent = ReadInt();
+					if (seq < 0 || seq >= left.GetCount())
+						Fail("Invalid sibling");
+					refs.Add(seq);
+					refs.Add(parent);
+				}
+			}
+			else
+				st.kind = STEP_OPEN;
+		}
+		else if (w == "clause") {
+			if (ReadInt() != clauses.GetCount())
+				Fail("Clause ids are not consecutive");
+			Vector<int>& c = clauses.Add();
+			int count = ReadInt();
+			for(int i = 0; i < count && error.IsEmpty(); i++)
+				c.Add(ReadLiteral());
+		}
+		else if (w == "copy") {
+			if (ReadInt() != copies.GetCount())
+				Fail("Copy ids are not consecutive");
+			CheckCopy& c = copies.Add();
+			c.clause = ReadInt();
+			c.parent = ReadInt();
+			c.parent_lit = ReadInt();
+			c.entry = ReadInt();
+			binds.Add();
+		}
+		else if (w == "bind") {
+			int copy = ReadInt();
+			int var = ReadInt();
+			int id = ReadInt();
+			if (copy < 0 || copy >= copies.GetCount() || var < 0 || id < 0 || id >= ids.GetCount() || !IsTerm(nodes[ids[id]].kind))
+				Fail("Invalid binding");
+			else {
+				int x = MakeNode(N_VAR, names.FindAdd("_X" + IntStr(var)), Vector<int>());
+				if (binds[copy].Find(x) != -1)
+					Fail(Format("Variable %d of copy %d is bound twice", var, copy));
+				binds[copy].Add(x, ids[id]);
+			}
+		}
+		else if (w == "red") {
+			CheckReduction& r = reductions.Add();
+			r.copy = ReadInt();
+			r.lit = ReadInt();
+			r.ancestor = ReadInt();
+			r.ancestor_lit = ReadInt();
+		}
+		else if (w == "model") {
+			if (model_size)
+				Fail("Model given twice");
+			model_size = ReadInt();
+			if (error.IsEmpty() && model_size <= 0)
+				Fail("Empty domain");
+		}
+		else if (w == "fn" || w == "pred") {
+			// the size of a table depends on the domain, so it must come first
+			String key = w + " " + ReadWord();
+			int arity = ReadInt();
+			key << " " << arity;
+			int64 rows = 1;
+			for(int i = 0; i < arity && rows <= MAX_TABLE; i++)
+				rows *= model_size;
+			if (model_size <= 0)
+				Fail("Table before the model size");
+			else if (arity < 0 || rows > MAX_TABLE)
+				Fail("Invalid table size");
+			else if (model.Find(key) != -1)
+				Fail("Table given twice");
+			Vector<int>& t = model.GetAdd(key);
+			for(int i = 0; i < rows && error.IsEmpty(); i++) {
+				int v = ReadInt();
+				if (v < 0 || v >= (w == "fn" ? model_size : 2))
+					Fail("Invalid value in the model");
+				t.Add(v);
+			}
+		}
+		else
+			Fail("Unknown line: " + w);
+
+		if (error.IsEmpty() && !IsEol())
+			Fail("Unexpected data at the end of line");
+		NextLine();
+	}
+	pos = s;
+
+	if (!error.IsEmpty())
+		return CERT_FAILED;
+	if (!header)
+		return Fail("Empty certificate"), CERT_FAILED;
+	if (goal < 0)
+		return Fail("No goal"), CERT_FAILED;
+
+	if (engine == "sequent" && result == "proven")
+		return CheckSequentProof() ? CERT_OK : CERT_FAILED;
+	if (engine == "connection" && result == "proven")
+		return CheckConnectionProof() ? CERT_OK : CERT_FAILED;
+	if (engine == "model" && result == "unprovable")
+		return CheckModel() ? CERT_OK : CERT_FAILED;
+
+	error = Format("Nothing to check for %s engine with result %s", engine, result);
+	return CERT_UNCHECKED;
+}
+
+}
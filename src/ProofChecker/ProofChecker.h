@@ -0,0 +1,210 @@
+#ifndef _ProofChecker_ProofChecker_h
+#define _ProofChecker_ProofChecker_h
+
+#include <Core/Core.h>
+
+using namespace Upp;
+
+/*
+	ProofChecker
+	------------------------------------------------------------------------
+
+	Checks the certificates written by TheoremProver (Proof::GetCertificate)
+	without using any of its code. A file may contain any number of
+	certificates, each of them is
+
+		tpcert 1
+		engine sequent|connection|model
+		result proven|unprovable|unknown
+		n <id> var|uvar <name>                 term and formula nodes, children
+		n <id> fn|pred <name> <arity> <ids>    always before their parents
+		n <id> not <id>
+		n <id> and|or|imp <id> <id>
+		n <id> all|ex <variable id> <id>
+		axiom <id>
+		goal <id>
+		seq <id> <left count> <ids> <right count> <ids>
+		step <i> <seq> <parent step> expand L|R <principal> <count> <seqs>
+		step <i> <seq> <parent step> axiom
+		step <i> <seq> <parent step> unify <count> <uvar value>... <count> <seq parent step>...
+		step <i> <seq> <parent step> open
+		clause <i> <count> +|-<atom id>...      connection proofs: the clauses,
+		copy <i> <clause> <parent copy> <parent literal> <entry literal>
+		bind <copy> <variable> <term id>       the clause copies of the closed
+		red <copy> <literal> <copy> <literal>  tableau and their reductions
+		model <size>                           the size before the tables
+		fn|pred <name> <arity> <value for each argument tuple>
+		end
+
+	Sequent proofs are checked rule by rule, the closing substitution is
+	checked to be the same for every use of a unification term and to be
+	acyclic: an eigenvariable stands for a Skolem term of the unification
+	terms in its quantified formula, so no unification term may depend on
+	itself through them. For connection proofs the axioms and the negated
+	goal are clausified again, the same way as the prover does, and the
+	clauses must be the ones of the certificate. A clause variable _X<n> is
+	replaced by the term of its bind line in each copy, every entry literal
+	must be complementary to the literal it extends, and every other literal
+	of a copy must be extended, reduced with a complementary literal of its
+	path, or be a lemma: equal to a literal solved before it in the copy or
+	in one of its ancestors. Countermodels are checked by
+	evaluating the axioms and the goal. Every node, sequent and step is
+	visited a bounded number of times, so checking is linear in the size of
+	the certificate for the bounded depth proofs of the prover.
+
+	rejected.cert holds certificates which must fail: an instance whose
+	term is captured by a quantifier of the formula, and a model table
+	given before the size of the domain.
+
+	------------------------------------------------------------------------
+*/
+
+namespace ProofChecker {
+
+enum {
+	CERT_OK,
+	CERT_FAILED,
+	CERT_UNCHECKED
+};
+
+enum {
+	N_VAR,
+	N_UVAR,
+	N_FN,
+	N_PRED,
+	N_NOT,
+	N_AND,
+	N_OR,
+	N_IMP,
+	N_ALL,
+	N_EX
+};
+
+struct CheckNode : Moveable<CheckNode> {
+	int kind;
+	int name;
+	int first, count;
+};
+
+struct CheckStep : Moveable<CheckStep> {
+	int kind;
+	int seq;
+	int parent;
+	int side;
+	int principal;
+	int first, count;                // children or unify pairs in 'refs'
+	int first_closed, closed_count;  // sequent and parent pairs in 'refs'
+	int first_intro, intro_count;    // names introduced by the rule in 'intros'
+};
+
+struct CheckNnf : Moveable<CheckNnf> {
+	int kind;
+	int atom;
+	bool negative;
+	int a, b;
+};
+
+struct CheckCopy : Moveable<CheckCopy> {
+	int clause;
+	int parent, parent_lit, entry;
+};
+
+struct CheckReduction : Moveable<CheckReduction> {
+	int copy, lit;
+	int ancestor, ancestor_lit;
+};
+
+class CertificateChecker {
+
+	// hash consed term and formula nodes
+	Index<String> names;
+	Vector<CheckNode> nodes;
+	Vector<int> args;
+	VectorMap<String, int> table;
+
+	// certificate
+	Vector<int> ids;
+	Vector<int> axioms;
+	int goal;
+	Vector<Vector<int> > left, right;
+	Vector<CheckStep> steps;
+	Vector<int> refs;
+	Vector<int> intros;
+	Vector<int> intro_steps;
+
+	// connection proof, a literal is atom * 2 + 1 when it is negative
+	Vector<Vector<int> > clauses;
+	Vector<CheckCopy> copies;
+	Vector<VectorMap<int, int> > binds;
+	Vector<CheckReduction> reductions;
+
+	// clausification
+	Vector<CheckNnf> nnf;
+	Vector<int> clause_count;
+	Vector<int> scope_vars, scope_terms;  // bound variables and their clause terms
+	Vector<int> universal;
+	Vector<Vector<int> > definitions;
+	int var_counter, skolem_counter, definition_counter;
+
+	int model_size;
+	VectorMap<String, Vector<int> > model;
+
+	const char* s;
+	const char* end;
+	String error;
+
+	bool   IsEol() const;
+	String ReadWord();
+	int    ReadInt();
+	void   NextLine();
+	int    ReadNode();
+	int    ReadSequent();
+
+	int  MakeNode(int kind, int name, const Vector<int>& a);
+	int  GetArg(int node, int i) const {return args[nodes[node].first + i];}
+	int  Substitute(int node, int uvar, int value, VectorMap<int, int>& memo);
+	bool Match(int body, int var, int inst, int& term) const;
+	bool Match(int body, int var, int inst, int& term, Vector<int>& bound) const;
+	void GetFreeNames(int node, Vector<int>& bound, Index<int>& out) const;
+	void GetFreeNames(const Vector<int>& formulas, Index<int>& out) const;
+
+	bool Fail(const String& msg) {if (error.IsEmpty()) error = msg; return false;}
+	bool IsChild(int step, int seq) const;
+	bool CheckRule(int step);
+	bool CheckInstances(const Vector<int>& parent, const Vector<int>& child, int body, int var);
+	bool CheckEigen(int seq, const Vector<int>& parent, const Vector<int>& child, int principal, int body, int var);
+	bool CheckUnify(int step, VectorMap<int, int>& values, Index<int64>& closed);
+	int  FindIntro(int step, int name) const;
+	void GetDependencies(int name, const VectorMap<int, int>& bound, const VectorMap<int, Vector<int> >& introduced, Index<int>& out) const;
+	bool CheckAcyclic(const VectorMap<int, int>& values);
+	bool CheckSequentProof();
+
+	int  ReadLiteral();
+	int  AddNnf(int kind, int atom, bool negative, int a, int b);
+	int  MakeTerm(int node);
+	int  Nnf(int node, bool positive);
+	void Cnf(int node, Vector<Vector<int> >& out);
+	int  Define(int node);
+	void GetVariables(int term, Index<int>& vars) const;
+	void GetNnfVariables(int node, Index<int>& vars) const;
+	int  Instantiate(int node, const VectorMap<int, int>& values, VectorMap<int, int>& memo);
+	bool AddClauses(int formula, bool positive, Vector<Vector<int> >& out);
+	bool CheckClauses();
+	bool CheckConnectionProof();
+
+	bool Evaluate(int node, Vector<int>& env_vars, Vector<int>& env_values, bool& value);
+	bool EvaluateTerm(int node, const Vector<int>& env_vars, const Vector<int>& env_values, int& value);
+	bool CheckModel();
+
+	void Reset();
+
+public:
+
+	int Check(const char*& pos, const char* end);
+	String GetError() const {return error;}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include "ProofChecker.h"
+
+#ifdef flagMAIN
+
+using namespace ProofChecker;
+
+static void CheckAll(const String& data, const String& source, bool quiet, int* counts) {
+	CertificateChecker checker;
+	const char* pos = data.Begin();
+	const char* end = data.End();
+	int n = 0;
+
+	while (pos < end) {
+		while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n'))
+			pos++;
+		if (pos >= end)
+			break;
+
+		int result = checker.Check(pos, end);
+		counts[result]++;
+		n++;
+
+		if (result == CERT_FAILED)
+			Cout() << source << ":" << n << ": FAILED: " << checker.GetError() << "\n";
+		else if (!quiet)
+			Cout() << source << ":" << n << (result == CERT_OK ? ": ok" : ": unchecked") << "\n";
+	}
+}
+
+CONSOLE_APP_MAIN {
+	const Vector<String>& cmd = CommandLine();
+	bool quiet = false;
+	int counts[3] = {0, 0, 0};
+	int files = 0;
+	int ts = msecs();
+
+	for(int i = 0; i < cmd.GetCount(); i++) {
+		if (cmd[i] == "-q") {
+			quiet = true;
+			continue;
+		}
+		if (!FileExists(cmd[i])) {
+			Cerr() << "Unable to open " << cmd[i] << "\n";
+			SetExitCode(2);
+			return;
+		}
+		CheckAll(LoadFile(cmd[i]), cmd[i], quiet, counts);
+		files++;
+	}
+
+	if (!files)
+		CheckAll(LoadStream(Cin()), "stdin", quiet, counts);
+
+	Cout() << Format("%d certificates: %d ok, %d failed, %d unchecked (%d ms)\n",
+		counts[CERT_OK] + counts[CERT_FAILED] + counts[CERT_UNCHECKED],
+		counts[CERT_OK], counts[CERT_FAILED], counts[CERT_UNCHECKED], msecs(ts));
+
+	if (counts[CERT_FAILED])
+		SetExitCode(1);
+}
+
+#endif
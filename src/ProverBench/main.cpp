@@ -0,0 +1,239 @@
+#include <TheoremProver/TheoremProver.h>
+
+#ifdef flagMAIN
+
+using namespace TheoremProver;
+
+/*
+	ProverBench [-t <ms>] [-m <ms>] [-engine sequent|connection|all] [-csv <file>] [-json <file>] [-q] <directory or file>...
+
+	Every problem is proven with a time limit. The countermodel search runs
+	next to the proof for at most -m ms, 0 disables it. Files ending with .p
+	or .ax are read as TPTP, other files in the prover's own syntax: "axiom
+	<formula>" lines and the goal formula on any other line. Lines starting
+	with % or # are comments. The results can be written as CSV and JSON to
+	compare runs.
+*/
+
+struct BenchResult : Moveable<BenchResult> {
+	String problem;
+	String engine;
+	String result;
+	int    time;
+	int    expanded;
+	int64  unifications;
+	int    peak_kb;
+	String error;
+};
+
+static void LoadNativeProblem(const String& path, TptpProblem& problem) {
+	Vector<String> lines = Split(LoadFile(path), '\n');
+	for(int i = 0; i < lines.GetCount(); i++) {
+		String line = TrimBoth(lines[i]);
+		if (line.IsEmpty() || line[0] == '%' || line[0] == '#')
+			continue;
+
+		problem.formulas++;
+		if (line.StartsWith("axiom "))
+			problem.axioms.Add(UnsafeParse(line.Mid(6)));
+		else {
+			problem.goal = UnsafeParse(line);
+			problem.conjectures++;
+		}
+	}
+	if (!problem.goal.Is())
+		throw InvalidInputError ( Format( "%s: no goal formula.", path ) );
+}
+
+static bool IsTptpFile(const String& path) {
+	return path.EndsWith(".p") || path.EndsWith(".ax");
+}
+
+static void ResetPeakMemory() {
+	#ifdef PLATFORM_LINUX
+	FileOut out("/proc/self/clear_refs");
+	out << "5";
+	#endif
+}
+
+static int GetPeakMemory() {
+	#ifdef PLATFORM_LINUX
+	Vector<String> lines = Split(LoadFile("/proc/self/status"), '\n');
+	for(int i = 0; i < lines.GetCount(); i++)
+		if (lines[i].StartsWith("VmHWM:"))
+			return atoi(TrimBoth(lines[i].Mid(6)));
+	#endif
+	return 0;
+}
+
+static void FindProblems(const String& path, Vector<String>& out) {
+	if (!DirectoryExists(path)) {
+		out.Add(path);
+		return;
+	}
+
+	Vector<String> found;
+	for(FindFile ff(AppendFileName(path, "*")); ff; ff.Next()) {
+		if (ff.IsHidden())
+			continue;
+		if (ff.IsFolder())
+			FindProblems(ff.GetPath(), found);
+		else if (!ff.GetName().EndsWith(".ax"))
+			found.Add(ff.GetPath());
+	}
+	Sort(found);
+	out.Append(found);
+}
+
+static BenchResult RunProblem(const String& path, int engine, int time_limit, int model_limit) {
+	BenchResult r;
+	r.problem = path;
+	r.engine = engine == ENGINE_CONNECTION ? "connection" : "sequent";
+	r.time = 0;
+	r.expanded = 0;
+	r.unifications = 0;
+	r.peak_kb = 0;
+
+	ResetPeakMemory();
+	int ts = msecs();
+
+	// a session of its own, so the nodes of the problem are deleted with it
+	// and do not add to the peak memory of the problems after it
+	ProverSession session;
+	SessionScope __(session);
+	try {
+		TptpProblem problem;
+		if (IsTptpFile(path))
+			LoadTptpFile(path, problem);
+		else
+			LoadNativeProblem(path, problem);
+
+		Proof proof;
+		ProveFormula(problem.axioms, problem.goal, proof, engine, time_limit, model_limit);
+		r.result = proof.GetStatus();
+		r.expanded = proof.GetStepCount(STEP_EXPAND);
+		r.unifications = engine == ENGINE_CONNECTION ? proof.connection.inferences : proof.unifications;
+	}
+	catch (InvalidInputError e) {
+		r.result = "error";
+		r.error = e;
+	}
+
+	r.time = msecs(ts);
+	r.peak_kb = GetPeakMemory();
+	return r;
+}
+
+static String CsvField(const String& s) {
+	if (s.Find(',') < 0 && s.Find('"') < 0)
+		return s;
+	String out = "\"";
+	for(int i = 0; i < s.GetCount(); i++) {
+		if (s[i] == '"')
+			out.Cat('"');
+		out.Cat(s[i]);
+	}
+	out.Cat('"');
+	return out;
+}
+
+static String GetCsv(const Vector<BenchResult>& results) {
+	String out = "problem,engine,result,time_ms,expanded,unifications,peak_kb,error\n";
+	for(int i = 0; i < results.GetCount(); i++) {
+		const BenchResult& r = results[i];
+		out << CsvField(r.problem) << "," << r.engine << "," << r.result << ","
+		    << r.time << "," << r.expanded << "," << r.unifications << ","
+		    << r.peak_kb << "," << CsvField(r.error) << "\n";
+	}
+	return out;
+}
+
+static String GetJson(const Vector<BenchResult>& results, int time_limit) {
+	JsonArray arr;
+	for(int i = 0; i < results.GetCount(); i++) {
+		const BenchResult& r = results[i];
+		arr << Json("problem", r.problem)
+		           ("engine", r.engine)
+		           ("result", r.result)
+		           ("time_ms", r.time)
+		           ("expanded", r.expanded)
+		           ("unifications", r.unifications)
+		           ("peak_kb", r.peak_kb)
+		           ("error", r.error);
+	}
+	return ~Json("time_limit_ms", time_limit)("results", arr);
+}
+
+CONSOLE_APP_MAIN {
+	BreakNullVarDtor();
+
+	const Vector<String>& cmd = CommandLine();
+	int time_limit = 10000;
+	int model_limit = 1000;
+	Vector<int> engines;
+	String csv_path, json_path;
+	bool quiet = false;
+	bool bad = false;
+	Vector<String> problems;
+
+	for(int i = 0; i < cmd.GetCount(); i++) {
+		String a = cmd[i];
+		bool has_value = i + 1 < cmd.GetCount();
+		if (a == "-t" && has_value)
+			time_limit = atoi(cmd[++i]);
+		else if (a == "-m" && has_value)
+			model_limit = atoi(cmd[++i]);
+		else if (a == "-engine" && has_value) {
+			String e = cmd[++i];
+			if (e == "sequent" || e == "all")
+				engines.Add(ENGINE_SEQUENT);
+			if (e == "connection" || e == "all")
+				engines.Add(ENGINE_CONNECTION);
+			if (e != "sequent" && e != "connection" && e != "all")
+				bad = true;
+		}
+		else if (a == "-csv" && has_value)
+			csv_path = cmd[++i];
+		else if (a == "-json" && has_value)
+			json_path = cmd[++i];
+		else if (a == "-q")
+			quiet = true;
+		else
+			FindProblems(a, problems);
+	}
+
+	if (bad || problems.IsEmpty()) {
+		Cerr() << "Usage: ProverBench [-t ms] [-m ms] [-engine sequent|connection|all] [-csv file] [-json file] [-q] <directory or file>...\n";
+		SetExitCode(1);
+		return;
+	}
+	if (engines.IsEmpty())
+		engines.Add(ENGINE_SEQUENT);
+
+	Vector<BenchResult> results;
+	VectorMap<String, int> totals;
+	int total_time = 0;
+
+	for(int i = 0; i < problems.GetCount(); i++) {
+		for(int j = 0; j < engines.GetCount(); j++) {
+			BenchResult& r = results.Add(RunProblem(problems[i], engines[j], time_limit, model_limit));
+			totals.GetAdd(r.result, 0)++;
+			total_time += r.time;
+			if (!quiet)
+				Cout() << Format("%-40s %-10s %-12s %7d ms %8d exp %10d unif %8d KB\n",
+					r.problem, r.engine, r.result, r.time, r.expanded, (int)r.unifications, r.peak_kb);
+		}
+	}
+
+	String summary = Format("%d runs in %d ms:", results.GetCount(), total_time);
+	for(int i = 0; i < totals.GetCount(); i++)
+		summary << " " << totals[i] << " " << totals.GetKey(i);
+	Cout() << summary << "\n";
+
+	if (csv_path.GetCount() && !SaveFile(csv_path, GetCsv(results)))
+		Cerr() << "Unable to write " << csv_path << "\n";
+	if (json_path.GetCount() && !SaveFile(json_path, GetJson(results, time_limit)))
+		Cerr() << "Unable to write " << json_path << "\n";
+}
+
+#endif
@@ -0,0 +1,347 @@
+#include <TheoremProver/TheoremProver.h>
+
+#ifdef flagMAIN
+
+using namespace TheoremProver;
+
+/*
+	ProverMicroBench [-t <ms>] [-width <n>] [-depth <d,d,...>] [-free] [-csv <file>] [bench...]
+
+	Times the primitives of the parser and the prover on generated terms:
+	every function node has 'width' arguments and the leaves are at 'depth',
+	so a term has about width^depth nodes. Each benchmark is run with twice
+	the operations until one run takes at least the time limit, and that run
+	is reported as ns/op and allocs/op.
+
+	allocs/op counts the allocations of one operation by the RefCore pool,
+	which allocates every node, sequent and other reference object, in the
+	pool of the thread or in a region. The buffers of strings and containers
+	come from the heap and are not included. With -free the nodes are not
+	registered in the node context and are deleted with their last reference.
+
+	Benchmarks: lex parse unify unifylist replace tostring hash hashcold index
+*/
+
+enum {
+	LEAF_CONSTANT,
+	LEAF_VARIABLE,
+	LEAF_UNIFICATION
+};
+
+struct MicroResult : Moveable<MicroResult> {
+	String name;
+	int    depth;
+	int    nodes;
+	int64  ops;
+	double ns;
+	double allocs;  // pool allocations per operation
+};
+
+struct OpTimer {
+	int64 time;
+	int64 allocs;
+	int64 start_time;
+	int64 start_allocs;
+
+	OpTimer() : time(0), allocs(0), start_time(0), start_allocs(0) {}
+	void Start() {start_allocs = GetRefAllocCount(); start_time = usecs();}
+	void Stop()  {time += usecs(start_time); allocs += GetRefAllocCount() - start_allocs;}
+};
+
+static String GetFunctionName(int depth) {
+	// the parser takes only lower case letters as function names
+	return String('f' + depth % 20, 1);
+}
+
+static NodeVar GenerateTerm(int depth, int width, int leaf, int& counter) {
+	if (depth <= 0) {
+		int i = counter++;
+		if (leaf == LEAF_VARIABLE)
+			return new Variable(Format("x%d", i));
+		if (leaf == LEAF_UNIFICATION)
+			return new UnificationTerm(Format("t%d", i));
+		return new TheoremProver::Function(Format("c%d", i), Index<NodeVar>());
+	}
+
+	Index<NodeVar> args;
+	for(int i = 0; i < width; i++)
+		args.Add(GenerateTerm(depth - 1, width, leaf, counter));
+	return new TheoremProver::Function(GetFunctionName(depth), args);
+}
+
+static NodeVar GenerateTerm(int depth, int width, int leaf) {
+	int counter = 0;
+	return GenerateTerm(depth, width, leaf, counter);
+}
+
+static String GenerateTermText(int depth, int width, int& counter) {
+	if (depth <= 0)
+		return counter++ & 1 ? "y" : "x";
+
+	String out = GetFunctionName(depth) + "(";
+	for(int i = 0; i < width; i++) {
+		if (i) out << ", ";
+		out << GenerateTermText(depth - 1, width, counter);
+	}
+	out << ")";
+	return out;
+}
+
+static String GenerateFormulaText(int depth, int width) {
+	int counter = 0;
+	String a = GenerateTermText(depth, width, counter);
+	String b = GenerateTermText(depth, width, counter);
+	return "forall x. forall y. (P(" + a + ") implies Q(" + b + "))";
+}
+
+static int GetNodeCount(int depth, int width) {
+	int nodes = 1, level = 1;
+	for(int i = 0; i < depth; i++) {
+		level *= width;
+		nodes += level;
+	}
+	return nodes;
+}
+
+// The context keeps every node until it is cleared, so each run creates its
+// own inputs and the context is cleared after it. A run stops growing when it
+// has allocated max_nodes objects, which bounds the memory of the benchmark.
+static const int max_nodes = 1 << 20;
+
+template <class F>
+static MicroResult Measure(const String& name, int depth, int width, int time_limit, F op) {
+	MicroResult r;
+	r.name = name;
+	r.depth = depth;
+	r.nodes = GetNodeCount(depth, width);
+
+	for(int64 n = 1; ; n *= 2) {
+		OpTimer t;
+		int64 allocs = GetRefAllocCount();
+		int64 ops = op(n, t);
+		allocs = GetRefAllocCount() - allocs;
+		GetSession().GetContext().Clear();
+		if (t.time >= (int64)time_limit * 1000 || allocs >= max_nodes || n >= ((int64)1 << 30)) {
+			r.ops = ops;
+			r.ns = ops ? t.time * 1000.0 / ops : 0;
+			r.allocs = ops ? (double)t.allocs / ops : 0;
+			return r;
+		}
+	}
+}
+
+static void RunBench(const String& bench, int depth, int width, int time_limit, Vector<MicroResult>& out) {
+	if (bench == "lex") {
+		String text = GenerateFormulaText(depth, width);
+		TokenList tokens;
+		out.Add(Measure("lex", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			t.Start();
+			for(int64 i = 0; i < n; i++)
+				tokens.Lex(text);
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "parse") {
+		TokenList tokens;
+		tokens.Lex(GenerateFormulaText(depth, width));
+		out.Add(Measure("parse", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			if (!Parse(tokens).Is())
+				throw InvalidInputError("Generated formula does not parse.");
+			t.Start();
+			for(int64 i = 0; i < n; i++)
+				Parse(tokens);
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "unify") {
+		out.Add(Measure("unify", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar a = GenerateTerm(depth, width, LEAF_UNIFICATION);
+			NodeVar b = GenerateTerm(depth, width, LEAF_CONSTANT);
+			VectorMap<NodeVar, NodeVar> sub;
+			if (!Unify(*a, *b, sub))
+				throw InvalidInputError("Generated terms do not unify.");
+			t.Start();
+			for(int64 i = 0; i < n; i++) {
+				sub.Trim(0);
+				Unify(*a, *b, sub);
+			}
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "unifylist") {
+		// one equation for each argument of the generated terms
+		out.Add(Measure("unifylist", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar a = GenerateTerm(depth, width, LEAF_UNIFICATION);
+			NodeVar b = GenerateTerm(depth, width, LEAF_CONSTANT);
+			VectorMap<NodeVar, NodeVar> pairs, sub;
+			for(int i = 0; i < a->GetCount(); i++)
+				pairs.Add(&(*a)[i], &(*b)[i]);
+			if (pairs.GetCount() && !UnifyList(pairs, sub))
+				throw InvalidInputError("Generated terms do not unify.");
+			t.Start();
+			for(int64 i = 0; i < n; i++) {
+				sub.Trim(0);
+				UnifyList(pairs, sub);
+			}
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "replace") {
+		out.Add(Measure("replace", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar term = GenerateTerm(depth, width, LEAF_VARIABLE);
+			NodeVar old = new Variable("x0");
+			NodeVar new_ = GenerateTerm(1, width, LEAF_CONSTANT);
+			t.Start();
+			for(int64 i = 0; i < n; i++)
+				term->Replace(*old, *new_);
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "tostring") {
+		out.Add(Measure("tostring", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar term = GenerateTerm(depth, width, LEAF_CONSTANT);
+			t.Start();
+			for(int64 i = 0; i < n; i++)
+				term->ToString();
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "hash") {
+		uint32 h = 0;
+		out.Add(Measure("hash", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar term = GenerateTerm(depth, width, LEAF_CONSTANT);
+			t.Start();
+			for(int64 i = 0; i < n; i++)
+				h += term.GetHashValue();
+			t.Stop();
+			return n;
+		}));
+	}
+	else if (bench == "hashcold") {
+		// the hash is cached in the node, so every operation hashes a fresh
+		// copy made by Replace outside of the timed loop; the leaves are
+		// shared and keep their cached hash
+		uint32 h = 0;
+		out.Add(Measure("hashcold", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			NodeVar term = GenerateTerm(depth, width, LEAF_VARIABLE);
+			NodeVar old = new Variable("none");
+			const int batch = 1024;
+			Vector<NodeVar> copies;
+			for(int64 done = 0; done < n; done += batch) {
+				int count = (int)min<int64>(batch, n - done);
+				copies.SetCount(0);
+				for(int i = 0; i < count; i++)
+					copies.Add(term->Replace(*old, *old));
+				t.Start();
+				for(int i = 0; i < count; i++)
+					h += copies[i].GetHashValue();
+				t.Stop();
+			}
+			return n;
+		}));
+	}
+	else if (bench == "index") {
+		// insertion of distinct terms with cached hashes into an empty index
+		const int count = 256;
+		out.Add(Measure("index", depth, width, time_limit, [&](int64 n, OpTimer& t) {
+			Vector<NodeVar> terms;
+			int counter = 0;
+			for(int i = 0; i < count; i++) {
+				terms.Add(GenerateTerm(depth, width, LEAF_CONSTANT, counter));
+				terms.Top().GetHashValue();
+			}
+			t.Start();
+			for(int64 i = 0; i < n; i++) {
+				Index<NodeVar> idx;
+				for(int j = 0; j < count; j++)
+					idx.Add(terms[j]);
+			}
+			t.Stop();
+			return n * count;
+		}));
+	}
+	else
+		throw InvalidInputError(Format("Unknown benchmark: %s", bench));
+}
+
+static String GetCsv(const Vector<MicroResult>& results) {
+	String out = "bench,depth,nodes,ops,ns_per_op,allocs_per_op\n";
+	for(int i = 0; i < results.GetCount(); i++) {
+		const MicroResult& r = results[i];
+		out << r.name << "," << r.depth << "," << r.nodes << "," << r.ops << ","
+		    << Format("%.1f", r.ns) << "," << Format("%.2f", r.allocs) << "\n";
+	}
+	return out;
+}
+
+CONSOLE_APP_MAIN {
+	BreakNullVarDtor();
+
+	const Vector<String>& cmd = CommandLine();
+	int time_limit = 200;
+	int width = 2;
+	Vector<int> depths;
+	String csv_path;
+	bool free_nodes = false;
+	Vector<String> benches;
+
+	for(int i = 0; i < cmd.GetCount(); i++) {
+		String a = cmd[i];
+		bool has_value = i + 1 < cmd.GetCount();
+		if (a == "-t" && has_value)
+			time_limit = max(1, atoi(cmd[++i]));
+		else if (a == "-width" && has_value)
+			width = max(1, atoi(cmd[++i]));
+		else if (a == "-depth" && has_value) {
+			Vector<String> d = Split(cmd[++i], ',');
+			for(int j = 0; j < d.GetCount(); j++)
+				depths.Add(max(0, atoi(d[j])));
+		}
+		else if (a == "-csv" && has_value)
+			csv_path = cmd[++i];
+		else if (a == "-free")
+			free_nodes = true;
+		else if (a.StartsWith("-")) {
+			Cerr() << "Usage: ProverMicroBench [-t ms] [-width n] [-depth d,d,...] [-free] [-csv file] [bench...]\n";
+			SetExitCode(1);
+			return;
+		}
+		else
+			benches.Add(a);
+	}
+
+	if (depths.IsEmpty())
+		depths << 1 << 3 << 5 << 7;
+	if (benches.IsEmpty())
+		benches << "lex" << "parse" << "unify" << "unifylist" << "replace"
+		        << "tostring" << "hash" << "hashcold" << "index";
+
+	GetSession().SetRegisterNodes(!free_nodes);
+
+	Vector<MicroResult> results;
+	try {
+		for(int i = 0; i < benches.GetCount(); i++) {
+			for(int j = 0; j < depths.GetCount(); j++) {
+				RunBench(benches[i], depths[j], width, time_limit, results);
+				const MicroResult& r = results.Top();
+				Cout() << Format("%-10s depth %2d %7d nodes %12d ops %12.1f ns/op %9.2f allocs/op\n",
+					r.name, r.depth, r.nodes, (int)r.ops, r.ns, r.allocs);
+			}
+		}
+	}
+	catch (InvalidInputError e) {
+		Cerr() << e << "\n";
+		SetExitCode(1);
+	}
+
+	if (csv_path.GetCount() && !SaveFile(csv_path, GetCsv(results)))
+		Cerr() << "Unable to write " << csv_path << "\n";
+}
+
+#endif
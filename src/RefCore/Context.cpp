@@ -6,6 +6,19 @@ RefContext& GetRefContext() {
 	return Single<RefContext>();
 }
 
+static thread_local RefContext* thread_region;
+
+RefContext* GetThreadRegion() {
+	return thread_region;
+}
+
+RefContext* SetThreadRegion(RefContext* region) {
+	ASSERT(!region || region->IsRegion());
+	RefContext* prev = thread_region;
+	thread_region = region;
+	return prev;
+}
+
 
 
 RefContext::RefContext() : RefRefContext(0) {
@@ -17,68 +30,79 @@ RefContext::~RefContext() {
 }
 
 void RefContext::Clear() {
-	while (ptrs.GetCount()) {
-		int pos = ptrs.GetCount()-1;
-		RefBase* ref = ptrs[pos];
-		ptrs.Remove(pos);
-		ASSERT(ref != 0);
-		ref->PrepareForcedDelete();
-		delete ref;
+	Mutex::Lock __(lock);
+	Vector<RefBase*> refs = pick(ptrs);
+	if (IsRegion()) {
+		// the objects are not counted, so a destructor releasing a handle
+		// to another one of them leaves it alone
+		for(int i = refs.GetCount()-1; i >= 0; i--)
+			refs[i]->~RefBase();
+		region->Free();
+		return;
 	}
+	DeleteForced(refs);
 }
 
 void RefContext::FastClear() {
-	for(int i = ptrs.GetCount()-1; i >= 0; i--) {
-		ptrs[i]->PrepareForcedDelete();
-	}
-	for(int i = ptrs.GetCount()-1; i >= 0; i--) {
-		delete ptrs[i];
-	}
-	ptrs.Clear();
+	Clear();
 }
 
 int RefContext::GetMemoryLinkCount() {
+	Mutex::Lock __(lock);
 	return ptrs.GetCount();
 }
 
 RefBase* RefContext::GetMemoryLink(int i) {
+	Mutex::Lock __(lock);
 	return ptrs[i];
 }
 
-void RefContext::AddRef(int id, RefBase* ref) {
-	ASSERT(ref != (RefBase*)this);
-	ptrs.Add(id, ref);
-	ref->Inc();
+void RefContext::SetRegion() {
+	ASSERT(ptrs.IsEmpty());
+	region.Create();
 }
 
-void RefContext::ChangeRef(int old_id, int new_id) {
-	int i = ptrs.Find(old_id);
-	ASSERT(i >= 0);
-	ptrs.SetKey(i, new_id);
+void RefContext::AddRef(RefBase* ref) {
+	ASSERT(ref != (RefBase*)this);
+	if (IsRegion()) {
+		ref->refs = -1;
+		ref->slot = ptrs.GetCount();
+		ptrs.Add(ref);
+		return;
+	}
+	Mutex::Lock __(lock);
+	ref->slot = ptrs.GetCount();
+	ptrs.Add(ref);
+	ref->Inc();
 }
 
-void RefContext::RemoveRef(int id, RefBase* ref) {
-	ASSERT(id >= 0);
-	garbage.Add(id);
-	if (garbage.GetCount() > 10000)
-		FreeGarbage();
+void RefContext::RemoveRef(RefBase* ref) {
+	Mutex::Lock __(lock);
+	int i = ref->slot;
+	ASSERT(i >= 0 && i < ptrs.GetCount() && ptrs[i] == ref);
+	RefBase* last = ptrs.Top();
+	ptrs[i] = last;
+	last->slot = i;
+	ptrs.Drop();
+	ref->slot = -1;
 }
 
-void RefContext::FreeGarbage() {
-	Sort(garbage, StdLess<int>());
-	Vector<int> garbage_pos;
-	garbage_pos.SetCount(garbage.GetCount());
-	int count = 0;
-	for(int i = 0; i < garbage.GetCount(); i++) {
-		int j = ptrs.Find(garbage[i]);
-		if (j == -1) continue;
-		garbage_pos[count] = j;
-		count++;
+void RefContext::Adopt(RefContext& src) {
+	ASSERT(&src != this);
+	ASSERT(!IsRegion() && !src.IsRegion());
+	Vector<RefBase*> refs;
+	{
+		Mutex::Lock __(src.lock);
+		refs = pick(src.ptrs);
+	}
+	Mutex::Lock __(lock);
+	ptrs.Reserve(ptrs.GetCount() + refs.GetCount());
+	for(int i = 0; i < refs.GetCount(); i++) {
+		RefBase* ref = refs[i];
+		ref->ctx = this;
+		ref->slot = ptrs.GetCount();
+		ptrs.Add(ref);
 	}
-	garbage.Clear();
-	garbage_pos.SetCount(count);
-	Sort(garbage_pos, StdLess<int>());
-	ptrs.Remove(garbage_pos);
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include "Ref.h"
 #include "Var.h"
+#include "Cycle.h"
 
 namespace RefCore {
 	
@@ -20,11 +21,30 @@ ScriptLinkRef GetMemoryLink(int i);
 */
 
 
+// The context may be shared by threads: its bookkeeping is locked. Reference
+// counts are not atomic, so a node must not be shared between threads.
+// The references are kept in a dense array and each one knows its slot in
+// it, so registration and removal take constant time: a removed reference
+// is replaced by the last one. Adopt moves the references of another
+// context, e.g. one filled by a worker thread, without touching their
+// counts. Clearing the context deletes its references even if they are
+// still referenced, so with VAR_FORCEUNSAFE no handle outside of the
+// context may be left to them.
+//
+// A context made a region with SetRegion owns the memory of its objects.
+// While it is the region of a thread, every reference object created on the
+// thread is allocated in it and belongs to it, whatever context its
+// constructor is given. The objects of a region are not counted, Inc and
+// Dec leave them alone, and they are added without the lock, as a region is
+// used by one thread at a time. Clearing the region runs their destructors
+// and then frees its memory at once. An object given a region as its
+// context while it's allocated elsewhere is a free object.
 class RefContext : public Ref<RefContext> {
 	typedef Ref<RefContext> RefRefContext;
 	
-	VectorMap<int, RefBase*> ptrs;
-	Vector<int> garbage;
+	Vector<RefBase*> ptrs;
+	Mutex lock;
+	One<RegionPool> region;
 	
 public:
 	RefContext();
@@ -33,17 +53,26 @@ public:
 	int GetMemoryLinkCount();
 	RefBase* GetMemoryLink(int i);
 	
-	void AddRef(int id, RefBase* ref);
-	void ChangeRef(int old_id, int new_id);
-	void RemoveRef(int id, RefBase* ref);
-	void FreeGarbage();
+	void AddRef(RefBase* ref);
+	void RemoveRef(RefBase* ref);
+	void Adopt(RefContext& src);
 	void Clear();
 	void FastClear();
 	
+	void SetRegion();
+	bool IsRegion() const {return !region.IsEmpty();}
+	void* Alloc(size_t size) {return region->Alloc(size);}
+	bool Owns(const void* ptr) const {return region->Contains(ptr);}
+	
 };
 
 RefContext& GetRefContext();
 
+// The region the reference objects created on this thread are allocated
+// in, NULL for the pool. SetThreadRegion returns the previous one.
+RefContext* GetThreadRegion();
+RefContext* SetThreadRegion(RefContext* region);
+
 typedef Var<RefContext> RefContextVar;
 
 }
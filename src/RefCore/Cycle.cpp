@@ -0,0 +1,98 @@
+#include "Context.h"
+#include "Cycle.h"
+
+namespace RefCore {
+
+static thread_local Vector<RefBase*> cycle_roots;
+
+void AddCycleRoot(RefBase& ref) {
+	ref.Inc();
+	cycle_roots.Add(&ref);
+}
+
+int GetCycleRootCount() {
+	return cycle_roots.GetCount();
+}
+
+int CollectCycles() {
+	Vector<RefBase*>& roots = cycle_roots;
+	if (roots.IsEmpty())
+		return 0;
+
+	// the objects reachable from the roots, with their counts less the
+	// references held by the roots buffer and by each other
+	Index<RefBase*> objs;
+	Vector<int> trial;
+	Vector<int> stack;
+	Vector<RefBase*> refs;
+
+	for(int i = 0; i < roots.GetCount(); i++) {
+		RefBase* root = roots[i];
+		int j = objs.Find(root);
+		if (j < 0) {
+			j = objs.GetCount();
+			objs.Add(root);
+			trial.Add(root->refs);
+			stack.Add(j);
+		}
+		trial[j]--;
+	}
+
+	while (stack.GetCount()) {
+		RefBase* obj = objs[stack.Pop()];
+		refs.SetCount(0);
+		obj->GetReferences(refs);
+		for(int i = 0; i < refs.GetCount(); i++) {
+			RefBase* ref = refs[i];
+			if (!ref || ref->ctx)
+				continue;
+			int j = objs.Find(ref);
+			if (j < 0) {
+				j = objs.GetCount();
+				objs.Add(ref);
+				trial.Add(ref->refs);
+				stack.Add(j);
+			}
+			trial[j]--;
+		}
+	}
+
+	// objects with references from outside and everything they reach are live
+	Vector<bool> live;
+	live.SetCount(objs.GetCount(), false);
+	for(int i = 0; i < objs.GetCount(); i++) {
+		ASSERT(trial[i] >= 0);
+		if (trial[i] > 0 && !live[i]) {
+			live[i] = true;
+			stack.Add(i);
+		}
+	}
+	while (stack.GetCount()) {
+		RefBase* obj = objs[stack.Pop()];
+		refs.SetCount(0);
+		obj->GetReferences(refs);
+		for(int i = 0; i < refs.GetCount(); i++) {
+			int j = refs[i] ? objs.Find(refs[i]) : -1;
+			if (j >= 0 && !live[j]) {
+				live[j] = true;
+				stack.Add(j);
+			}
+		}
+	}
+
+	// the live roots stay in the buffer, the others are garbage
+	int count = 0;
+	for(int i = 0; i < roots.GetCount(); i++)
+		if (live[objs.Find(roots[i])])
+			roots[count++] = roots[i];
+	roots.SetCount(count);
+
+	Vector<RefBase*> garbage;
+	for(int i = 0; i < objs.GetCount(); i++)
+		if (!live[i])
+			garbage.Add(objs[i]);
+	RefBase::DeleteForced(garbage);
+	return garbage.GetCount();
+}
+
+}
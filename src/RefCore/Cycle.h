@@ -0,0 +1,33 @@
+#ifndef _TheoremProver_Cycle_h_
+#define _TheoremProver_Cycle_h_
+
+namespace RefCore {
+
+/*
+	Collector of reference cycles.
+
+	A reference which may become part of a cycle, such as an object holding
+	a handle to itself, is added to the root buffer of the thread with
+	AddCycleRoot. The buffer holds one reference to it until a collection
+	finds it unreachable.
+
+	CollectCycles is a synchronous trial deletion: it walks the objects
+	reachable from the buffered roots by GetReferences, subtracts the
+	references they hold to each other from their counts, and deletes the
+	objects which are not reachable from one with references left. Objects
+	registered in a context are kept by it and end the walk. A class which
+	does not report its handles is only ever kept, never deleted too early.
+
+	Roots must be used by the thread which added them, and the buffer of a
+	thread is not collected when the thread ends.
+*/
+
+void AddCycleRoot(RefBase& ref);
+int  GetCycleRootCount();
+
+// returns the number of deleted objects
+int  CollectCycles();
+
+}
+
+#endif
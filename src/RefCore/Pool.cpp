@@ -0,0 +1,202 @@
+#include "Pool.h"
+
+namespace RefCore {
+
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+#define POOL_ALIGN __STDCPP_DEFAULT_NEW_ALIGNMENT__
+#else
+#define POOL_ALIGN 16
+#endif
+
+// The header is padded to the alignment of operator new. Chunks come from
+// malloc and the block sizes are multiples of it, so every block is as
+// aligned as an object allocated with new.
+enum {
+	POOL_LARGE = POOL_CLASSES,
+	POOL_REGION,
+	POOL_HEADER = POOL_ALIGN > sizeof(size_t) ? POOL_ALIGN : sizeof(size_t),
+};
+
+static_assert(POOL_STEP % POOL_HEADER == 0, "pool blocks must keep the alignment of new");
+
+struct PoolBlock {
+	PoolBlock* next;
+};
+
+// Plain data, so that the pool of a thread is still usable by the
+// destructors that run after its flush, e.g. of static objects.
+struct ThreadPool {
+	PoolBlock* free[POOL_CLASSES];
+	byte* chunk;
+	byte* chunk_end;
+	bool registered;
+	bool flushed;
+};
+
+static thread_local ThreadPool thread_pool;
+static thread_local int64 alloc_count;
+
+int64 GetRefAllocCount() {
+	return alloc_count;
+}
+
+static SpinLock global_lock;
+static PoolBlock* global_free[POOL_CLASSES];
+
+static void FlushThreadPool() {
+	ThreadPool& p = thread_pool;
+	SpinLock::Lock __(global_lock);
+	for(int i = 0; i < POOL_CLASSES; i++) {
+		PoolBlock* b = p.free[i];
+		if (!b) continue;
+		while (b->next)
+			b = b->next;
+		b->next = global_free[i];
+		global_free[i] = p.free[i];
+		p.free[i] = NULL;
+	}
+	p.flushed = true;
+}
+
+struct ThreadPoolFlush {
+	~ThreadPoolFlush() {FlushThreadPool();}
+};
+
+static void RegisterThreadPool(ThreadPool& p) {
+	static thread_local ThreadPoolFlush flush;
+	(void)&flush;
+	p.registered = true;
+}
+
+static void* AllocLarge(size_t size) {
+	byte* b = (byte*)malloc(size + POOL_HEADER);
+	if (!b)
+		throw std::bad_alloc();
+	*(size_t*)b = POOL_LARGE;
+	return b + POOL_HEADER;
+}
+
+static PoolBlock* AllocNew(ThreadPool& p, int cls) {
+	if (!p.registered)
+		RegisterThreadPool(p);
+
+	{
+		SpinLock::Lock __(global_lock);
+		if (global_free[cls]) {
+			PoolBlock* b = global_free[cls];
+			global_free[cls] = NULL;
+			p.free[cls] = b->next;
+			return b;
+		}
+	}
+
+	size_t block = (cls + 1) * POOL_STEP + POOL_HEADER;
+	if (p.chunk_end - p.chunk < (ptrdiff_t)block) {
+		p.chunk = (byte*)malloc(POOL_CHUNK);
+		if (!p.chunk)
+			throw std::bad_alloc();
+		p.chunk_end = p.chunk + POOL_CHUNK;
+	}
+	byte* b = p.chunk;
+	p.chunk += block;
+	*(size_t*)b = cls;
+	return (PoolBlock*)(b + POOL_HEADER);
+}
+
+void* RefAlloc(size_t size) {
+	alloc_count++;
+	#ifdef REF_NOPOOL
+	return AllocLarge(size);
+	#else
+	if (size > POOL_MAX || size == 0)
+		return AllocLarge(size);
+
+	ThreadPool& p = thread_pool;
+	if (p.flushed)
+		return AllocLarge(size);
+
+	int cls = (int)((size - 1) / POOL_STEP);
+	PoolBlock* b = p.free[cls];
+	if (!b)
+		return AllocNew(p, cls);
+	p.free[cls] = b->next;
+	return b;
+	#endif
+}
+
+void RefFree(void* ptr) {
+	if (!ptr)
+		return;
+	byte* b = (byte*)ptr - POOL_HEADER;
+	size_t cls = *(size_t*)b;
+	if (cls == POOL_REGION)
+		return;
+	if (cls == POOL_LARGE) {
+		free(b);
+		return;
+	}
+
+	PoolBlock* block = (PoolBlock*)ptr;
+	ThreadPool& p = thread_pool;
+	if (p.flushed) {
+		SpinLock::Lock __(global_lock);
+		block->next = global_free[cls];
+		global_free[cls] = block;
+		return;
+	}
+	if (!p.registered)
+		RegisterThreadPool(p);
+	block->next = p.free[cls];
+	p.free[cls] = block;
+}
+
+byte* RegionPool::AddChunk(size_t size) {
+	byte* b = (byte*)malloc(size);
+	if (!b)
+		throw std::bad_alloc();
+	Chunk& c = chunks.Add();
+	c.begin = b;
+	c.end = b + size;
+	return b;
+}
+
+// A block larger than a quarter of a chunk gets a chunk of its own, so the
+// rest of the current chunk is not wasted.
+void* RegionPool::Alloc(size_t size) {
+	alloc_count++;
+	size_t block = (size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN + POOL_HEADER;
+	byte* b;
+	if (block > POOL_CHUNK / 4)
+		b = AddChunk(block);
+	else {
+		if (chunk_end - chunk < (ptrdiff_t)block) {
+			chunk_begin = chunk = AddChunk(POOL_CHUNK);
+			chunk_end = chunk + POOL_CHUNK;
+		}
+		b = chunk;
+		chunk += block;
+	}
+	*(size_t*)b = POOL_REGION;
+	return b + POOL_HEADER;
+}
+
+// The object of a block is constructed right after the block is cut, so it's
+// nearly always in the current chunk, or else in one of the last ones.
+bool RegionPool::Contains(const void* ptr) const {
+	const byte* p = (const byte*)ptr;
+	if (p >= chunk_begin && p < chunk)
+		return true;
+	for(int i = chunks.GetCount() - 1; i >= 0; i--)
+		if (p >= chunks[i].begin && p < chunks[i].end)
+			return true;
+	return false;
+}
+
+void RegionPool::Free() {
+	for(int i = 0; i < chunks.GetCount(); i++)
+		free(chunks[i].begin);
+	chunks.Clear();
+	chunk_begin = chunk = chunk_end = NULL;
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef _TheoremProver_Pool_h_
+#define _TheoremProver_Pool_h_
+
+#include <Core/Core.h>
+using namespace Upp;
+
+namespace RefCore {
+
+/*
+	Size-class pool of the reference objects.
+
+	Every RefBase object outside of a region is allocated by RefAlloc. Sizes
+	up to POOL_MAX bytes are rounded to a size class, and blocks of a class
+	are cut from large chunks and reused through a free list of the thread.
+	Allocation and deallocation are then a pop and a push of the list, and
+	the nodes of a search lie close to each other in memory.
+
+	A block may be freed by another thread than the one that allocated it:
+	it goes to the free list of the freeing thread. The lists of an ending
+	thread are passed to the other threads. Chunks are never returned to the
+	system, so the memory of a pool stays at its peak.
+
+	A block starts with its size class, padded to the alignment of operator
+	new, so RefFree needs only the pointer.
+
+	A RegionPool cuts blocks of any size from chunks of its own, one after
+	the other. Its blocks are not freed one by one, RefFree ignores them:
+	Free returns every chunk of the region at once. Contains tells from the
+	address alone whether an object lies in the memory of the region, and
+	answers at once for the chunk blocks are currently cut from. The blocks
+	of a region are cut from its chunks even with REF_NOPOOL.
+
+	Define REF_NOPOOL to allocate every object from the heap, e.g. for memory
+	checking tools.
+*/
+
+enum {
+	POOL_STEP = 16,
+	POOL_MAX = 1024,
+	POOL_CLASSES = POOL_MAX / POOL_STEP,
+	POOL_CHUNK = 64 * 1024,
+};
+
+void* RefAlloc(size_t size);
+void  RefFree(void* ptr);
+
+// blocks allocated by RefAlloc and the regions on this thread, for benchmarks
+int64 GetRefAllocCount();
+
+class RegionPool : NoCopy {
+	struct Chunk : Moveable<Chunk> {
+		byte* begin;
+		byte* end;
+	};
+	
+	Vector<Chunk> chunks;
+	byte* chunk_begin;
+	byte* chunk;
+	byte* chunk_end;
+
+	byte* AddChunk(size_t size);
+
+public:
+	RegionPool() : chunk_begin(NULL), chunk(NULL), chunk_end(NULL) {}
+	~RegionPool() {Free();}
+
+	void* Alloc(size_t size);
+	void  Free();
+	bool  Contains(const void* ptr) const;
+	bool  IsEmpty() const {return chunks.IsEmpty();}
+
+};
+
+}
+
+#endif
@@ -3,10 +3,31 @@
 
 namespace RefCore {
 
-RefBase::RefBase(RefContext* ctx) : refs(0), ctx(ctx) {
+void* RefBase::operator new(size_t size) {
+	RefContext* region = GetThreadRegion();
+	if (!region)
+		return RefAlloc(size);
+	return region->Alloc(size);
+}
+
+RefBase::RefBase(RefContext* ctx) : ctx(ctx), refs(0), slot(-1) {
+	#ifdef flagDEBUG
 	id = 0;
 	Renew();
 	REFLOG(Format("RefBase new id=%d", id));
+	#endif
+	
+	// an object belongs to the region it's allocated in, and only to it. The
+	// memory tells it: the arguments of a new expression may allocate other
+	// objects between the allocation and the constructor.
+	RefContext* region = GetThreadRegion();
+	if (region && region->Owns(this))
+		this->ctx = region;
+	else if (ctx && ctx->IsRegion())
+		this->ctx = NULL;
+	
+	if (this->ctx)
+		this->ctx->AddRef(this);
 }
 
 RefBase::~RefBase() {
@@ -16,24 +37,25 @@ RefBase::~RefBase() {
 	}
 	#endif
 	
-	ASSERT(refs == 0); // Fail here means, that
+	ASSERT(refs <= 0); // Fail here means, that
 	// some Ref<> object is not created with new-operator.
 	// RefBase inheriting classes may NOT be created in stack memory, because
 	// destructor code-position in function has higher priority than reference-count!
 	// However, some circular reference-decrease by virtual destructor might also be the problem.
 	
-	if (ctx)
-		ctx->RemoveRef(id, this);
+	if (ctx && refs >= 0)
+		ctx->RemoveRef(this);
 }
 
 RefBase& RefBase::Inc() {
+	if (refs < 0) return *this;
 	refs++;
 	REFLOG(Format("RefBase++ %d id=%d", refs, id));
 	return *this;
 }
 
 RefBase& RefBase::Dec() {
-	if (id == -1) return *this;
+	if (refs < 0) return *this;
 	ASSERT(refs > 0);
 	refs--;
 	REFLOG(Format("RefBase-- %d id=%d", refs, id));
@@ -49,9 +71,26 @@ RefBase& RefBase::Dec() {
 	return *this;
 }
 
+void RefBase::DeleteForced(const Vector<RefBase*>& refs) {
+	// The references may refer to each other in any order, and the handles
+	// of plain pointers are not reset by deletion. Every destructor is run
+	// before any memory is returned, so a handle released by a destructor
+	// only finds the forced delete mark of a destroyed reference.
+	Vector<void*> mem;
+	mem.SetCount(refs.GetCount());
+	for(int i = refs.GetCount()-1; i >= 0; i--) {
+		ASSERT(refs[i] != 0);
+		mem[i] = dynamic_cast<void*>(refs[i]);
+		refs[i]->PrepareForcedDelete();
+	}
+	for(int i = refs.GetCount()-1; i >= 0; i--)
+		refs[i]->~RefBase();
+	for(int i = mem.GetCount()-1; i >= 0; i--)
+		operator delete(mem[i]);
+}
+
+#ifdef flagDEBUG
 void RefBase::Renew() {
-	int prev_id = id;
-	
 	static SpinLock lock;
 	lock.Enter();
 	{
@@ -62,13 +101,7 @@ void RefBase::Renew() {
 		}
 	}
 	lock.Leave();
-	
-	if (ctx) {
-		if (prev_id == 0)
-			ctx->AddRef(id, this);
-		else
-			ctx->ChangeRef(prev_id, id);
-	}
 }
+#endif
 
 }
@@ -4,6 +4,8 @@
 #include <Core/Core.h>
 using namespace Upp;
 
+#include "Pool.h"
+
 namespace RefCore {
 
 #if defined(VERBOSE_REF) && defined(flagDEBUG)
@@ -12,7 +14,19 @@ namespace RefCore {
 	#define REFLOG(x)
 #endif
 
-//#ifdef flagDEBUG
+// Release builds hold references in Var handles by plain pointers: a handle
+// is one word and a copy only increases the reference count. Debug builds
+// use Ptr, which is reset when the object is deleted, so a handle that
+// outlives its object is caught. Define VAR_FORCEUNSAFE or VAR_FORCESAFE to
+// choose either one.
+#if !defined(flagDEBUG) && !defined(VAR_FORCESAFE) && !defined(VAR_FORCEUNSAFE)
+	#define VAR_FORCEUNSAFE
+#endif
+
+// Ids and their breakpoints exist only in debug builds. In release builds a
+// reference costs its count and the context pointer, and the break functions
+// do nothing.
+#ifdef flagDEBUG
 extern int __ref_id_counter;
 extern int __ref_break_id;
 extern int __ref_break_id_dec;
@@ -20,37 +34,65 @@ extern int __ref_break_id_dtor;
 inline void BreakRefId(int id) {__ref_break_id = id;}
 inline void BreakRefIdDec(int id) {__ref_break_id_dec = id;}
 inline void BreakRefIdDtor(int id) {__ref_break_id_dtor = id;}
-//#endif
+#else
+inline void BreakRefId(int id) {}
+inline void BreakRefIdDec(int id) {}
+inline void BreakRefIdDtor(int id) {}
+#endif
 
 class RefContext;
 
 class RefBase {
 	RefContext* ctx;
 	int refs;
+	int slot; // position in the context
+	#ifdef flagDEBUG
 	int id;
+	#endif
 	
 protected:
 	friend class RefContext;
+	friend int CollectCycles();
 	
-	//#ifdef flagDEBUG
+	#ifdef flagDEBUG
 	void Renew();
-	//#endif
+	#else
+	void Renew() {}
+	#endif
+	
+	// refs == -1 marks an object deleted by its context, or one of a region:
+	// it ignores Inc and Dec
+	void PrepareForcedDelete() {ctx = NULL; refs = -1;}
 	
-	void PrepareForcedDelete() {ctx = NULL; refs = 0; id = -1;}
+	// Deletes the references even if they are still referenced
+	static void DeleteForced(const Vector<RefBase*>& refs);
 	
 public:
 
 	RefBase(RefContext* ctx);
 	virtual ~RefBase();
+	
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr) {RefFree(ptr);}
+	
 	RefContext& GetContext() {return *ctx;}
+	bool IsInContext(const RefContext* c) const {return ctx == c;}
 	RefBase& Inc();
 	RefBase& Dec();
 	int GetRefs() const {return refs;}
 	
+	// Adds the reference of every handle held by the object, for the cycle
+	// collector. A class which does not add them is never collected.
+	virtual void GetReferences(Vector<RefBase*>& out) {}
+	
 };
 
 template <class T>
+#ifdef VAR_FORCEUNSAFE
+class Ref : public RefBase {
+#else
 class Ref : public Pte<T>, public RefBase {
+#endif
 	
 	
 protected:
@@ -2,7 +2,7 @@
 
 namespace RefCore {
 	
-//#ifdef flagDEBUG
+#ifdef flagDEBUG
 int __var_id_counter;
 int __var_break_id;
 int __var_break_id_chk;
@@ -12,7 +12,7 @@ int __ref_id_counter;
 int __ref_break_id;
 int __ref_break_id_dec;
 int __ref_break_id_dtor;
-//#endif
+#endif
 
 }
 
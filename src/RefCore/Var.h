@@ -17,7 +17,9 @@ struct NullRef : public Exc {
 	NullRef(const String& s) : Exc(s) {}
 };
 
-//#ifdef flagDEBUG
+// As with references, the ids and checks of Var handles exist only in debug
+// builds. In release builds a copy of a handle only increases the count.
+#ifdef flagDEBUG
 extern int __var_id_counter;
 extern int __var_break_id;
 extern int __var_break_id_chk;
@@ -28,7 +30,12 @@ inline void BreakNullVarDtor(bool b=true) {__var_break_null_dtor = true;}
 inline void BreakVarId(int id) {__var_break_id = id;}
 inline void BreakVarIdChk(int id) {__var_break_id_chk = id;}
 inline void BreakVarIdDtor(int id) {__var_break_id_dtor = id;}
-//#endif
+#else
+inline void BreakNullVarDtor(bool b=true) {}
+inline void BreakVarId(int id) {}
+inline void BreakVarIdChk(int id) {}
+inline void BreakVarIdDtor(int id) {}
+#endif
 
 template <class T>
 class Var : Moveable<Var<T> > {
@@ -42,7 +49,7 @@ protected:
 	Ptr<T> node;
 	#endif
 	
-	//#ifdef flagDEBUG
+	#ifdef flagDEBUG
 	void RenewId() {
 		static SpinLock lock;
 		lock.Enter();
@@ -60,7 +67,8 @@ protected:
 		RenewId();
 	}
 	inline void Chk() const {
-		//ASSERT(&*node != (T*)0x800000000000000);
+		if (!id)
+			return;
 		if (!node && __var_break_null_dtor) {
 			Panic("Pointer is null. Id: " + IntStr(id));
 		}
@@ -76,12 +84,12 @@ protected:
 		id = 0;
 	}
 	int id;
-	/*#else
+	#else
 	inline void DebugCtor() const {}
 	inline void Chk() const {}
 	inline void ChkDtor() const {}
 	inline void RenewId() const {}
-	#endif*/
+	#endif
 	
 	
 	
@@ -117,7 +125,7 @@ public:
 	}
 	
 	~Var() {
-		if (id) Chk();
+		Chk();
 		if (node) {
 			T* n = &*node;
 			node = 0;
@@ -170,7 +178,7 @@ public:
 	
 	// NEVER operator bool() {return node;}
 	bool Is() const {
-		if (id) Chk();
+		Chk();
 		return &*node != 0;
 	}
 	
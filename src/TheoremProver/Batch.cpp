@@ -0,0 +1,144 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+struct BatchGoal : Moveable<BatchGoal> {
+	int    line;
+	String text;
+};
+
+class BatchWriter {
+	Stream& out;
+	Mutex lock;
+	Vector<String> lines;
+	Vector<bool> done;
+	VectorMap<String, int> totals;
+	int next;
+
+public:
+	BatchWriter(Stream& out, int count) : out(out), next(0) {
+		lines.SetCount(count);
+		done.SetCount(count, false);
+	}
+
+	void Put(int i, const String& status, const String& line) {
+		Mutex::Lock __(lock);
+		lines[i] = line;
+		done[i] = true;
+		totals.GetAdd(status, 0)++;
+		while (next < done.GetCount() && done[next]) {
+			out << lines[next] << "\n";
+			lines[next].Clear();
+			next++;
+		}
+		out.Flush();
+	}
+
+	const VectorMap<String, int>& GetTotals() const {return totals;}
+};
+
+static String GetEngineName(int engine) {
+	return engine == ENGINE_CONNECTION ? "connection" : "sequent";
+}
+
+static String ProveGoal(const Index<NodeVar>& axioms, int i, const BatchGoal& goal, const BatchOptions& opt, String& status) {
+	Json json("goal", i);
+	json("line", goal.line)
+	    ("formula", goal.text)
+	    ("engine", GetEngineName(opt.engine));
+
+	int ts = msecs();
+	try {
+		// the goal is a free node, deleted when the goal is done, and the
+		// search runs in the region of its proof, so nothing of the goal is
+		// left in the context of the session
+		NodeVar formula;
+		{
+			FreeNodeScope free_scope;
+			formula = UnsafeParse(goal.text);
+		}
+		CheckFormula ( *formula );
+
+		Proof proof;
+		ProveFormula(axioms, formula, proof, opt.engine, opt.time_limit, opt.model_limit);
+		status = proof.GetStatus();
+		json("status", status)
+		    ("time_ms", msecs(ts))
+		    ("expanded", proof.GetStepCount(STEP_EXPAND))
+		    ("unifications", opt.engine == ENGINE_CONNECTION ? proof.connection.inferences : (int64)proof.unifications);
+		if (proof.model.size)
+			json("model_size", proof.model.size);
+	}
+	catch (InvalidInputError e) {
+		status = "error";
+		json("status", status)
+		    ("time_ms", msecs(ts))
+		    ("error", (String)e);
+	}
+	return ~json;
+}
+
+static void ParseAxioms(const Vector<String>& lines, Index<NodeVar>& axioms) {
+	for(int i = 0; i < lines.GetCount(); i++)
+		axioms.FindAdd(UnsafeParse(lines[i]));
+}
+
+VectorMap<String, int> ProveBatch(const String& problem, Stream& out, const BatchOptions& opt) {
+	Vector<String> axiom_lines;
+	Vector<BatchGoal> goals;
+
+	Vector<String> lines = Split(problem, '\n', false);
+	for(int i = 0; i < lines.GetCount(); i++) {
+		String line = TrimBoth(lines[i]);
+		if (line.IsEmpty() || line[0] == '#' || line[0] == '%')
+			continue;
+
+		if (line.StartsWith("axiom ")) {
+			String text = TrimBoth(line.Mid(6));
+			try {
+				CheckFormula ( *UnsafeParse(text) );
+			}
+			catch (InvalidInputError e) {
+				throw InvalidInputError ( Format( "line %d: %s", i + 1, e ) );
+			}
+			axiom_lines.Add(text);
+		}
+		else {
+			BatchGoal& g = goals.Add();
+			g.line = i + 1;
+			g.text = line;
+		}
+	}
+
+	int threads = opt.threads > 0 ? opt.threads : CPU_Cores();
+	threads = max(1, min(threads, goals.GetCount()));
+
+	BatchWriter writer(out, goals.GetCount());
+	Atomic next;
+	next = 0;
+
+	CoWork co;
+	for(int t = 0; t < threads; t++) {
+		co & [&] {
+			ProverSession session;
+			SessionScope __(session);
+			ParseAxioms(axiom_lines, session.axioms);
+
+			for(;;) {
+				int i = AtomicInc(next) - 1;
+				if (i >= goals.GetCount())
+					break;
+				String status;
+				String line = ProveGoal(session.axioms, i, goals[i], opt, status);
+				writer.Put(i, status, line);
+			}
+		};
+	}
+	co.Finish();
+
+	VectorMap<String, int> totals;
+	totals <<= writer.GetTotals();
+	return totals;
+}
+
+}
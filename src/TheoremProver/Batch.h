@@ -0,0 +1,34 @@
+#ifndef _TheoremProver_Batch_h_
+#define _TheoremProver_Batch_h_
+
+namespace TheoremProver {
+
+/*
+	Batch mode.
+
+	Proves the goals of a problem file on a pool of threads and writes one
+	JSON line per goal, in the order of the goals, as soon as it and all the
+	goals before it are done. The file has one formula per line: lines
+	starting with "axiom" are axioms of every goal, lines starting with # or
+	% are comments and every other line is a goal.
+
+	Every worker proves in its own ProverSession: it parses the axioms once
+	and then takes the next goal until all goals are done, so no node or
+	node context is shared between the threads.
+*/
+
+struct BatchOptions {
+	int engine;
+	int time_limit;   // milliseconds per goal, 0 for none
+	int model_limit;  // milliseconds of the countermodel search per goal, 0 for none
+	int threads;      // 0 for one per core
+
+	BatchOptions() : engine(ENGINE_SEQUENT), time_limit(0), model_limit(1000), threads(0) {}
+};
+
+// Returns the number of goals with each status
+VectorMap<String, int> ProveBatch(const String& problem, Stream& out, const BatchOptions& opt = BatchOptions());
+
+}
+
+#endif
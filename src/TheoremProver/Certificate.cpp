@@ -0,0 +1,244 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+// Nodes are written once, children first, so every line refers only to earlier ids
+static int ExportNode(Node& n, Index<NodeVar>& ids, String& out) {
+	NodeVar var(&n);
+	int i = ids.Find(var);
+	if (i != -1)
+		return i;
+
+	Vector<int> args;
+	for(int j = 0; j < n.GetCount(); j++)
+		args.Add(ExportNode(n[j], ids, out));
+
+	i = ids.GetCount();
+	ids.Add(var);
+	out << "n " << i << " ";
+
+	if (dynamic_cast<Variable*>(&n))
+		out << "var " << n.GetName();
+	else if (dynamic_cast<UnificationTerm*>(&n))
+		out << "uvar " << n.GetName();
+	else if (dynamic_cast<Function*>(&n))
+		out << "fn " << n.GetName() << " " << args.GetCount();
+	else if (dynamic_cast<Predicate*>(&n))
+		out << "pred " << n.GetName() << " " << args.GetCount();
+	else if (dynamic_cast<Not*>(&n))
+		out << "not";
+	else if (dynamic_cast<And*>(&n))
+		out << "and";
+	else if (dynamic_cast<Or*>(&n))
+		out << "or";
+	else if (dynamic_cast<Implies*>(&n))
+		out << "imp";
+	else if (dynamic_cast<ForAll*>(&n))
+		out << "all";
+	else if (dynamic_cast<ThereExists*>(&n))
+		out << "ex";
+	else
+		throw InvalidInputError ( Format( "Invalid formula: %s.", n.ToString() ) );
+
+	for(int j = 0; j < args.GetCount(); j++)
+		out << " " << args[j];
+	out << "\n";
+	return i;
+}
+
+// Clause terms, with the variables of a clause written as _X<n>
+static int ExportClauseTerm(const ClauseSet& cs, int term, VectorMap<int, int>& ids, int& next, String& out) {
+	int i = ids.Find(term);
+	if (i != -1)
+		return ids[i];
+
+	const ClauseTerm& t = cs.terms[term];
+	Vector<int> args;
+	for(int j = 0; j < t.count; j++)
+		args.Add(ExportClauseTerm(cs, cs.GetArg(term, j), ids, next, out));
+
+	int id = next++;
+	ids.Add(term, id);
+	out << "n " << id << " ";
+	if (t.symbol < 0)
+		out << "var _X" << t.var;
+	else
+		out << (cs.predicate[t.symbol] ? "pred " : "fn ") << cs.names[t.symbol] << " " << t.count;
+	for(int j = 0; j < args.GetCount(); j++)
+		out << " " << args[j];
+	out << "\n";
+	return id;
+}
+
+static int ExportInstance(const ClauseSet& cs, const ConnectionResult& r, int term, int off,
+                          VectorMap<int64, int>& ids, int& next, String& out);
+
+// The value of a variable slot under the final bindings of a connection proof,
+// a slot left unbound is written as _U<slot>
+static int ExportSlot(const ClauseSet& cs, const ConnectionResult& r, int slot,
+                      VectorMap<int64, int>& ids, int& next, String& out) {
+	if (r.slot_term[slot] >= 0)
+		return ExportInstance(cs, r, r.slot_term[slot], r.slot_off[slot], ids, next, out);
+
+	int64 key = -1 - (int64)slot;
+	int i = ids.Find(key);
+	if (i != -1)
+		return ids[i];
+	int id = next++;
+	ids.Add(key, id);
+	out << "n " << id << " var _U" << slot << "\n";
+	return id;
+}
+
+static int ExportInstance(const ClauseSet& cs, const ConnectionResult& r, int term, int off,
+                          VectorMap<int64, int>& ids, int& next, String& out) {
+	const ClauseTerm& t = cs.terms[term];
+	if (t.symbol < 0)
+		return ExportSlot(cs, r, t.var + off, ids, next, out);
+
+	int64 key = ((int64)term << 32) | (uint32)off;
+	int i = ids.Find(key);
+	if (i != -1)
+		return ids[i];
+
+	Vector<int> args;
+	for(int j = 0; j < t.count; j++)
+		args.Add(ExportInstance(cs, r, cs.GetArg(term, j), off, ids, next, out));
+
+	int id = next++;
+	ids.Add(key, id);
+	out << "n " << id << " fn " << cs.names[t.symbol] << " " << t.count;
+	for(int j = 0; j < args.GetCount(); j++)
+		out << " " << args[j];
+	out << "\n";
+	return id;
+}
+
+// The clauses, the clause copies of the closed tableau with the instances of
+// their variables, and the reductions. Node ids continue from 'next'.
+static void ExportConnectionProof(const ClauseSet& cs, const ConnectionResult& r, int next, String& out) {
+	String lines;
+	VectorMap<int, int> term_ids;
+	VectorMap<int64, int> instance_ids;
+
+	for(int i = 0; i < cs.clauses.GetCount(); i++) {
+		const Clause& c = cs.clauses[i];
+		lines << "clause " << i << " " << c.count;
+		for(int j = 0; j < c.count; j++) {
+			const ClauseLiteral& lit = cs.GetLiteral(c, j);
+			lines << " " << (lit.negative ? "-" : "+") << ExportClauseTerm(cs, lit.atom, term_ids, next, out);
+		}
+		lines << "\n";
+	}
+
+	for(int i = 0; i < r.copies.GetCount(); i++) {
+		const ConnectionCopy& c = r.copies[i];
+		lines << "copy " << i << " " << c.clause << " " << c.parent << " " << c.parent_lit << " " << c.entry << "\n";
+		for(int v = 0; v < cs.clauses[c.clause].var_count; v++)
+			lines << "bind " << i << " " << v << " " << ExportSlot(cs, r, c.off + v, instance_ids, next, out) << "\n";
+	}
+
+	for(int i = 0; i < r.reductions.GetCount(); i++) {
+		const ConnectionReduction& red = r.reductions[i];
+		lines << "red " << red.copy << " " << red.lit << " " << red.ancestor << " " << red.ancestor_lit << "\n";
+	}
+
+	out << lines;
+}
+
+static String GetResultName(const Proof& proof) {
+	if (proof.proven)
+		return "proven";
+	// only a countermodel is a checkable answer, an exhausted connection search is not
+	if (proof.model.size)
+		return "unprovable";
+	return "unknown";
+}
+
+String Proof::GetCertificate() const {
+	String out;
+	Index<NodeVar> ids;
+	Vector<int> node_ids;
+
+	out << "tpcert 1\n";
+	if (model.size)
+		out << "engine model\n";
+	else
+		out << "engine " << (engine == ENGINE_CONNECTION ? "connection" : "sequent") << "\n";
+	out << "result " << GetResultName(*this) << "\n";
+
+	Vector<int> axiom_ids;
+	for(int i = 0; i < axioms.GetCount(); i++)
+		axiom_ids.Add(ExportNode(*axioms[i], ids, out));
+	int goal_id = ExportNode(*goal, ids, out);
+
+	bool sequent_proof = !model.size && engine == ENGINE_SEQUENT;
+	if (sequent_proof)
+		for(int i = 0; i < nodes.GetCount(); i++)
+			node_ids.Add(sequents.Find(i) == -1 ? ExportNode(*nodes[i], ids, out) : -1);
+
+	for(int i = 0; i < axiom_ids.GetCount(); i++)
+		out << "axiom " << axiom_ids[i] << "\n";
+	out << "goal " << goal_id << "\n";
+
+	if (!model.size && engine == ENGINE_CONNECTION && proven)
+		ExportConnectionProof(clauses, connection, ids.GetCount(), out);
+
+	if (sequent_proof) {
+		for(int i = 0; i < sequents.GetCount(); i++) {
+			const ProofSequent& s = sequents[i];
+			out << "seq " << i << " " << s.left;
+			for(int j = 0; j < s.left; j++)
+				out << " " << node_ids[sequent_formulas[s.first + j]];
+			out << " " << s.right;
+			for(int j = 0; j < s.right; j++)
+				out << " " << node_ids[sequent_formulas[s.first + s.left + j]];
+			out << "\n";
+		}
+
+		for(int i = 0; i < steps.GetCount(); i++) {
+			const ProofStep& s = steps[i];
+			out << "step " << i << " " << sequents.Find(s.sequent) << " " << s.parent;
+
+			switch (s.kind) {
+			case STEP_EXPAND:
+				out << " expand " << (s.side == SIDE_LEFT ? "L" : "R") << " " << node_ids[s.formula];
+				out << " " << s.child_count;
+				for(int j = 0; j < s.child_count; j++)
+					out << " " << sequents.Find(children[s.first_child + j]);
+				break;
+			case STEP_AXIOM:
+				out << " axiom";
+				break;
+			case STEP_UNIFY:
+				out << " unify " << s.count;
+				for(int j = 0; j < s.count; j++)
+					out << " " << node_ids[bindings[s.first + 2 * j]] << " " << node_ids[bindings[s.first + 2 * j + 1]];
+				out << " " << s.closed_count;
+				for(int j = 0; j < s.closed_count; j++)
+					out << " " << sequents.Find(closed[s.first_closed + 2 * j]) << " " << closed[s.first_closed + 2 * j + 1];
+				break;
+			default:
+				out << " open";
+				break;
+			}
+			out << "\n";
+		}
+	}
+
+	if (model.size) {
+		out << "model " << model.size << "\n";
+		for(int i = 0; i < model.names.GetCount(); i++) {
+			out << (model.predicate[i] ? "pred " : "fn ") << model.names[i] << " " << model.arity[i];
+			const Vector<int>& t = model.table[i];
+			for(int j = 0; j < t.GetCount(); j++)
+				out << " " << t[j];
+			out << "\n";
+		}
+	}
+
+	out << "end\n";
+	return out;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef _TheoremProver_Clause_h_
+#define _TheoremProver_Clause_h_
+
+namespace TheoremProver {
+
+/*
+	Clause normal form for the clause based engines.
+
+	All terms live flat in one bank: a term is either a clause local variable
+	(symbol == -1) or a symbol applied to a range of argument term ids in 'args'.
+	Atoms are terms whose symbol is a predicate. Free variables of the input
+	formulas are constants, like in the sequent prover.
+*/
+
+struct ClauseTerm : Moveable<ClauseTerm> {
+	int symbol;
+	int var;
+	int first, count;
+};
+
+struct ClauseLiteral : Moveable<ClauseLiteral> {
+	int atom;
+	bool negative;
+};
+
+struct Clause : Moveable<Clause> {
+	int first, count;
+	int var_count;
+	bool conjecture;
+};
+
+class ClauseSet {
+
+public:
+	Index<String> symbols;
+	Vector<String> names;
+	Vector<int> arity;
+	Vector<bool> predicate;
+
+	Vector<ClauseTerm> terms;
+	Vector<int> args;
+	Vector<ClauseLiteral> literals;
+	Vector<Clause> clauses;
+
+	int GetSymbol(const String& name, int arity, bool predicate);
+	int AddVariable(int var);
+	int AddTerm(int symbol, const Vector<int>& args);
+
+	int GetArg(int term, int i) const {return args[terms[term].first + i];}
+	const ClauseLiteral& GetLiteral(const Clause& c, int i) const {return literals[c.first + i];}
+	bool IsVariable(int term) const {return terms[term].symbol < 0;}
+	bool IsGround(int term) const;
+	bool IsSame(int a, int b) const;
+
+	String TermToString(int term) const;
+	String LiteralToString(const ClauseLiteral& lit) const;
+	String ClauseToString(int clause) const;
+
+	void Clear();
+
+};
+
+void Clausify(const Index<NodeVar>& axioms, const NodeVar& goal, ClauseSet& out);
+
+}
+
+#endif
@@ -0,0 +1,407 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+int ClauseSet::GetSymbol(const String& name, int arity, bool predicate) {
+	String key = (predicate ? "P:" : "F:") + name + "/" + IntStr(arity);
+	int i = symbols.Find(key);
+	if (i != -1)
+		return i;
+	symbols.Add(key);
+	names.Add(name);
+	this->arity.Add(arity);
+	this->predicate.Add(predicate);
+	return symbols.GetCount() - 1;
+}
+
+int ClauseSet::AddVariable(int var) {
+	ClauseTerm& t = terms.Add();
+	t.symbol = -1;
+	t.var = var;
+	t.first = 0;
+	t.count = 0;
+	return terms.GetCount() - 1;
+}
+
+int ClauseSet::AddTerm(int symbol, const Vector<int>& args) {
+	ClauseTerm& t = terms.Add();
+	t.symbol = symbol;
+	t.var = -1;
+	t.first = this->args.GetCount();
+	t.count = args.GetCount();
+	this->args.Append(args);
+	return terms.GetCount() - 1;
+}
+
+bool ClauseSet::IsGround(int term) const {
+	const ClauseTerm& t = terms[term];
+	if (t.symbol < 0)
+		return false;
+	for(int i = 0; i < t.count; i++)
+		if (!IsGround(args[t.first + i]))
+			return false;
+	return true;
+}
+
+bool ClauseSet::IsSame(int a, int b) const {
+	if (a == b)
+		return true;
+	const ClauseTerm& ta = terms[a];
+	const ClauseTerm& tb = terms[b];
+	if (ta.symbol != tb.symbol)
+		return false;
+	if (ta.symbol < 0)
+		return ta.var == tb.var;
+	for(int i = 0; i < ta.count; i++)
+		if (!IsSame(args[ta.first + i], args[tb.first + i]))
+			return false;
+	return true;
+}
+
+String ClauseSet::TermToString(int term) const {
+	const ClauseTerm& t = terms[term];
+	if (t.symbol < 0)
+		return "X" + IntStr(t.var);
+
+	String s = names[t.symbol];
+	if (t.count == 0)
+		return s;
+
+	s << "(";
+	for(int i = 0; i < t.count; i++) {
+		if (i) s << ", ";
+		s << TermToString(args[t.first + i]);
+	}
+	s << ")";
+	return s;
+}
+
+String ClauseSet::LiteralToString(const ClauseLiteral& lit) const {
+	return (lit.negative ? "¬" : "") + TermToString(lit.atom);
+}
+
+String ClauseSet::ClauseToString(int clause) const {
+	const Clause& c = clauses[clause];
+	if (c.count == 0)
+		return "⊥";
+
+	String s;
+	for(int i = 0; i < c.count; i++) {
+		if (i) s << " ∨ ";
+		s << LiteralToString(literals[c.first + i]);
+	}
+	return s;
+}
+
+void ClauseSet::Clear() {
+	symbols.Clear();
+	names.Clear();
+	arity.Clear();
+	predicate.Clear();
+	terms.Clear();
+	args.Clear();
+	literals.Clear();
+	clauses.Clear();
+}
+
+
+// Clausification: negation normal form, skolemization and distribution.
+// A disjunction whose distribution would give more than DEFINITION_LIMIT
+// clauses gets a fresh predicate over the variables of its larger side, which
+// is defined by its own clauses (structure preserving, Tseitin style), so the
+// clause set stays linear in the size of the formula.
+
+enum {DEFINITION_LIMIT = 64};
+
+class Clausifier {
+
+	enum {
+		NNF_LITERAL,
+		NNF_AND,
+		NNF_OR
+	};
+
+	struct NnfNode : Moveable<NnfNode> {
+		int kind;
+		int atom;
+		bool negative;
+		int a, b;
+	};
+
+	ClauseSet& cs;
+	Vector<NnfNode> nodes;
+	Vector<int> clause_count;   // clauses of the plain distribution of a node, at most DEFINITION_LIMIT + 1
+	VectorMap<String, int> env;
+	Vector<int> universal;
+	Vector<Vector<ClauseLiteral> > definitions;
+	int var_counter, skolem_counter, definition_counter;
+
+	int AddNode(int kind, int atom, bool negative, int a, int b);
+	int Term(Node& n);
+	int Nnf(Node& f, bool positive);
+	void Cnf(int node, Vector<Vector<ClauseLiteral> >& out);
+	int Define(int node);
+	void GetVariables(int term, Index<int>& vars) const;
+	void GetNodeVariables(int node, Index<int>& vars) const;
+	int Copy(int term, VectorMap<int, int>& vars);
+
+public:
+	Clausifier(ClauseSet& cs) : cs(cs), var_counter(0), skolem_counter(0), definition_counter(0) {}
+
+	void Add(Node& formula, bool conjecture);
+
+};
+
+int Clausifier::AddNode(int kind, int atom, bool negative, int a, int b) {
+	NnfNode& n = nodes.Add();
+	n.kind = kind;
+	n.atom = atom;
+	n.negative = negative;
+	n.a = a;
+	n.b = b;
+	int64 count = kind == NNF_LITERAL ? 1 :
+	              kind == NNF_AND ? (int64)clause_count[a] + clause_count[b] :
+	              (int64)clause_count[a] * clause_count[b];
+	clause_count.Add((int)min(count, (int64)DEFINITION_LIMIT + 1));
+	return nodes.GetCount() - 1;
+}
+
+int Clausifier::Term(Node& n) {
+	if (dynamic_cast<Variable*>(&n)) {
+		for(int i = env.GetCount() - 1; i >= 0; i--)
+			if (env.GetKey(i) == n.GetName())
+				return env[i];
+
+		// free variable: a constant
+		return cs.AddTerm(cs.GetSymbol(n.GetName(), 0, false), Vector<int>());
+	}
+
+	Vector<int> args;
+	for(int i = 0; i < n.GetCount(); i++)
+		args.Add(Term(n[i]));
+
+	bool is_pred = dynamic_cast<Predicate*>(&n);
+	return cs.AddTerm(cs.GetSymbol(n.GetName(), args.GetCount(), is_pred), args);
+}
+
+int Clausifier::Nnf(Node& f, bool positive) {
+	if (dynamic_cast<Predicate*>(&f))
+		return AddNode(NNF_LITERAL, Term(f), !positive, -1, -1);
+
+	if (dynamic_cast<Not*>(&f))
+		return Nnf(f[0], !positive);
+
+	if (dynamic_cast<And*>(&f)) {
+		int a = Nnf(f[0], positive);
+		int b = Nnf(f[1], positive);
+		return AddNode(positive ? NNF_AND : NNF_OR, -1, false, a, b);
+	}
+
+	if (dynamic_cast<Or*>(&f)) {
+		int a = Nnf(f[0], positive);
+		int b = Nnf(f[1], positive);
+		return AddNode(positive ? NNF_OR : NNF_AND, -1, false, a, b);
+	}
+
+	if (dynamic_cast<Implies*>(&f)) {
+		int a = Nnf(f[0], !positive);
+		int b = Nnf(f[1], positive);
+		return AddNode(positive ? NNF_OR : NNF_AND, -1, false, a, b);
+	}
+
+	bool is_forall = dynamic_cast<ForAll*>(&f);
+	bool is_exists = dynamic_cast<ThereExists*>(&f);
+	if (is_forall || is_exists) {
+		bool universal_var = is_forall == positive;
+		int term;
+
+		if (universal_var) {
+			term = cs.AddVariable(var_counter++);
+			universal.Add(term);
+		}
+		else {
+			String name = "_sk" + IntStr(++skolem_counter);
+			term = cs.AddTerm(cs.GetSymbol(name, universal.GetCount(), false), universal);
+		}
+
+		env.Add(f[0].GetName(), term);
+		int n = Nnf(f[1], positive);
+		env.Drop();
+
+		if (universal_var)
+			universal.Drop();
+		return n;
+	}
+
+	throw InvalidInputError ( Format( "Invalid formula: %s.", f.ToString() ) );
+}
+
+void Clausifier::Cnf(int node, Vector<Vector<ClauseLiteral> >& out) {
+	NnfNode n = nodes[node];  // a copy, Define adds nodes
+
+	if (n.kind == NNF_LITERAL) {
+		ClauseLiteral& lit = out.Add().Add();
+		lit.atom = n.atom;
+		lit.negative = n.negative;
+		return;
+	}
+
+	if (n.kind == NNF_AND) {
+		Cnf(n.a, out);
+		Cnf(n.b, out);
+		return;
+	}
+
+	// the larger side is defined first, then the other one if that is not enough
+	int na = n.a, nb = n.b;
+	if (clause_count[na] < clause_count[nb])
+		Swap(na, nb);
+	if (clause_count[na] * clause_count[nb] > DEFINITION_LIMIT)
+		na = Define(na);
+	if (clause_count[na] * clause_count[nb] > DEFINITION_LIMIT)
+		nb = Define(nb);
+
+	Vector<Vector<ClauseLiteral> > a, b;
+	Cnf(na, a);
+	Cnf(nb, b);
+	for(int i = 0; i < a.GetCount(); i++) {
+		for(int j = 0; j < b.GetCount(); j++) {
+			Vector<ClauseLiteral>& c = out.Add();
+			c.Append(a[i]);
+			c.Append(b[j]);
+		}
+	}
+}
+
+// Returns a literal node d(x1, ..., xn) over the variables of the node and adds
+// the clauses of "not d or node". The node occurs only positively, so the other
+// direction of the definition is not needed.
+int Clausifier::Define(int node) {
+	Index<int> vars;
+	GetNodeVariables(node, vars);
+	Vector<int> args;
+	for(int i = 0; i < vars.GetCount(); i++)
+		args.Add(cs.AddVariable(vars[i]));
+	String name = "_def" + IntStr(++definition_counter);
+	int atom = cs.AddTerm(cs.GetSymbol(name, args.GetCount(), true), args);
+
+	Vector<Vector<ClauseLiteral> > cnf;
+	Cnf(node, cnf);
+	for(int i = 0; i < cnf.GetCount(); i++) {
+		Vector<ClauseLiteral>& c = definitions.Add();
+		ClauseLiteral& lit = c.Add();
+		lit.atom = atom;
+		lit.negative = true;
+		c.Append(cnf[i]);
+	}
+	return AddNode(NNF_LITERAL, atom, false, -1, -1);
+}
+
+void Clausifier::GetVariables(int term, Index<int>& vars) const {
+	const ClauseTerm& t = cs.terms[term];
+	if (t.symbol < 0) {
+		vars.FindAdd(t.var);
+		return;
+	}
+	for(int i = 0; i < t.count; i++)
+		GetVariables(cs.GetArg(term, i), vars);
+}
+
+void Clausifier::GetNodeVariables(int node, Index<int>& vars) const {
+	const NnfNode& n = nodes[node];
+	if (n.kind == NNF_LITERAL)
+		GetVariables(n.atom, vars);
+	else {
+		GetNodeVariables(n.a, vars);
+		GetNodeVariables(n.b, vars);
+	}
+}
+
+int Clausifier::Copy(int term, VectorMap<int, int>& vars) {
+	const ClauseTerm& t = cs.terms[term];
+
+	if (t.symbol < 0) {
+		int i = vars.Find(t.var);
+		if (i == -1) {
+			i = vars.GetCount();
+			vars.Add(t.var, i);
+		}
+		return cs.AddVariable(vars[i]);
+	}
+
+	if (cs.IsGround(term))
+		return term;
+
+	int symbol = t.symbol;
+	Vector<int> args;
+	for(int i = 0; i < t.count; i++)
+		args.Add(cs.GetArg(term, i));
+	for(int i = 0; i < args.GetCount(); i++)
+		args[i] = Copy(args[i], vars);
+	return cs.AddTerm(symbol, args);
+}
+
+void Clausifier::Add(Node& formula, bool conjecture) {
+	nodes.Clear();
+	clause_count.Clear();
+	env.Clear();
+	universal.Clear();
+	definitions.Clear();
+
+	int root = Nnf(formula, true);
+
+	Vector<Vector<ClauseLiteral> > cnf;
+	Cnf(root, cnf);
+	cnf.AppendPick(pick(definitions));
+
+	for(int i = 0; i < cnf.GetCount(); i++) {
+		Vector<ClauseLiteral>& lits = cnf[i];
+
+		// drop duplicate literals and tautologies
+		Vector<ClauseLiteral> unique;
+		bool tautology = false;
+		for(int j = 0; j < lits.GetCount() && !tautology; j++) {
+			bool duplicate = false;
+			for(int k = 0; k < unique.GetCount(); k++) {
+				if (!cs.IsSame(lits[j].atom, unique[k].atom))
+					continue;
+				if (lits[j].negative == unique[k].negative)
+					duplicate = true;
+				else
+					tautology = true;
+			}
+			if (!duplicate)
+				unique.Add(lits[j]);
+		}
+		if (tautology)
+			continue;
+
+		// number the variables from zero in each clause
+		VectorMap<int, int> vars;
+		Clause c;
+		c.first = cs.literals.GetCount();
+		c.count = unique.GetCount();
+		c.conjecture = conjecture;
+		for(int j = 0; j < unique.GetCount(); j++) {
+			ClauseLiteral lit;
+			lit.atom = Copy(unique[j].atom, vars);
+			lit.negative = unique[j].negative;
+			cs.literals.Add(lit);
+		}
+		c.var_count = vars.GetCount();
+		cs.clauses.Add(c);
+	}
+}
+
+void Clausify(const Index<NodeVar>& axioms, const NodeVar& goal, ClauseSet& out) {
+	Clausifier c(out);
+
+	for(int i = 0; i < axioms.GetCount(); i++)
+		c.Add(*axioms[i], false);
+
+	// refutation: the goal is proven when the axioms and the negated goal are unsatisfiable
+	NodeVar negated_goal = new Not(*goal);
+	c.Add(*negated_goal, true);
+}
+
+}
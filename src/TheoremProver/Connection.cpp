@@ -0,0 +1,494 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+class ConnectionProver {
+
+	struct Binding : Moveable<Binding> {
+		int term, off;
+	};
+
+	// persistent list cell of the active path and the lemma lists
+	struct Cell : Moveable<Cell> {
+		int atom, off;
+		bool negative;
+		int next;
+		int copy, lit;  // the literal of the path
+	};
+
+	// a clause copy whose literals from 'lit' on are still open
+	struct Frame : Moveable<Frame> {
+		int clause, off;
+		int copy;  // the frame which created the clause copy
+		int lit, skip;
+		int path, path_len;
+		int lemmas;
+		int parent;
+		int choice;
+	};
+
+	struct Occurrence : Moveable<Occurrence> {
+		int clause, lit;
+	};
+
+	// the open literal of a frame and its untried alternatives
+	struct ChoicePoint : Moveable<ChoicePoint> {
+		int frame;
+		int choice;
+		int trail_mark, cell_mark, frame_mark, slot_mark;
+		int reduction;    // next path cell to try, -1 when the reductions are done
+		int extension;    // next occurrence to try
+		int occurrences;  // index of the complementary occurrences, -1 for none
+		int reduced;      // the path cell of the last reduction, -1 for an extension
+	};
+
+	enum {CLOSED = -2};
+
+	const ClauseSet& cs;
+	ConnectionOptions opt;
+
+	Vector<Binding> bindings;
+	Vector<int> trail;
+	Vector<Cell> cells;
+	Vector<Frame> frames;
+	Vector<bool> cut;
+	Vector<ChoicePoint> choices;
+	VectorMap<int, Vector<Occurrence> > occurrences;
+
+	int path_limit;
+	bool restricted;
+	bool limit_hit;
+	bool timeout;
+	int64 inferences;
+	dword steps;  // turns of the search loop, backtracking included, may wrap
+
+	static int GetKey(int symbol, bool negative) {return symbol * 2 + (negative ? 1 : 0);}
+
+	void Deref(int& term, int& off) const;
+	bool Occurs(int slot, int term, int off) const;
+	bool Equal(int a, int ao, int b, int bo) const;
+	bool Unify(int a, int ao, int b, int bo);
+	void Bind(int slot, int term, int off);
+	int  AllocSlots(int count);
+	int  Cons(int atom, int off, bool negative, int next, int copy = -1, int lit = -1);
+	static int NextLit(int lit, int skip) {return lit == skip ? lit + 1 : lit;}
+	int  Advance(const Frame& f, int lemmas);
+	void Backtrack(int trail_mark, int cell_mark, int frame_mark, int slot_mark);
+	void Reset();
+	int  Expand(int fi);
+	int  NextAlternative(ChoicePoint& cp);
+	bool Solve(int fi);
+	void GetTableau(ConnectionResult& result) const;
+
+public:
+	ConnectionProver(const ClauseSet& cs, const ConnectionOptions& opt) : cs(cs), opt(opt) {}
+
+	ConnectionResult Prove();
+
+};
+
+void ConnectionProver::Deref(int& term, int& off) const {
+	while (true) {
+		const ClauseTerm& t = cs.terms[term];
+		if (t.symbol >= 0)
+			return;
+		const Binding& b = bindings[t.var + off];
+		if (b.term < 0)
+			return;
+		term = b.term;
+		off = b.off;
+	}
+}
+
+bool ConnectionProver::Occurs(int slot, int term, int off) const {
+	Deref(term, off);
+	const ClauseTerm& t = cs.terms[term];
+	if (t.symbol < 0)
+		return t.var + off == slot;
+	for(int i = 0; i < t.count; i++)
+		if (Occurs(slot, cs.args[t.first + i], off))
+			return true;
+	return false;
+}
+
+bool ConnectionProver::Equal(int a, int ao, int b, int bo) const {
+	Deref(a, ao);
+	Deref(b, bo);
+	const ClauseTerm& ta = cs.terms[a];
+	const ClauseTerm& tb = cs.terms[b];
+
+	if (ta.symbol < 0 || tb.symbol < 0)
+		return ta.symbol < 0 && tb.symbol < 0 && ta.var + ao == tb.var + bo;
+
+	if (ta.symbol != tb.symbol)
+		return false;
+	for(int i = 0; i < ta.count; i++)
+		if (!Equal(cs.args[ta.first + i], ao, cs.args[tb.first + i], bo))
+			return false;
+	return true;
+}
+
+void ConnectionProver::Bind(int slot, int term, int off) {
+	bindings[slot].term = term;
+	bindings[slot].off = off;
+	trail.Add(slot);
+}
+
+bool ConnectionProver::Unify(int a, int ao, int b, int bo) {
+	Deref(a, ao);
+	Deref(b, bo);
+	const ClauseTerm& ta = cs.terms[a];
+	const ClauseTerm& tb = cs.terms[b];
+
+	if (ta.symbol < 0) {
+		int slot = ta.var + ao;
+		if (tb.symbol < 0 && tb.var + bo == slot)
+			return true;
+		if (Occurs(slot, b, bo))
+			return false;
+		Bind(slot, b, bo);
+		return true;
+	}
+
+	if (tb.symbol < 0)
+		return Unify(b, bo, a, ao);
+
+	if (ta.symbol != tb.symbol)
+		return false;
+	for(int i = 0; i < ta.count; i++)
+		if (!Unify(cs.args[ta.first + i], ao, cs.args[tb.first + i], bo))
+			return false;
+	return true;
+}
+
+int ConnectionProver::AllocSlots(int count) {
+	int off = bindings.GetCount();
+	for(int i = 0; i < count; i++)
+		bindings.Add().term = -1;
+	return off;
+}
+
+int ConnectionProver::Cons(int atom, int off, bool negative, int next, int copy, int lit) {
+	Cell& c = cells.Add();
+	c.atom = atom;
+	c.off = off;
+	c.negative = negative;
+	c.next = next;
+	c.copy = copy;
+	c.lit = lit;
+	return cells.GetCount() - 1;
+}
+
+int ConnectionProver::Advance(const Frame& f, int lemmas) {
+	Frame next = f;
+	next.lit = NextLit(f.lit + 1, f.skip);
+	next.lemmas = lemmas;
+	frames.Add(next);
+	return frames.GetCount() - 1;
+}
+
+void ConnectionProver::Backtrack(int trail_mark, int cell_mark, int frame_mark, int slot_mark) {
+	while (trail.GetCount() > trail_mark)
+		bindings[trail.Pop()].term = -1;
+	cells.Trim(cell_mark);
+	frames.Trim(frame_mark);
+	bindings.Trim(slot_mark);
+}
+
+void ConnectionProver::Reset() {
+	bindings.Clear();
+	trail.Clear();
+	cells.Clear();
+	frames.Clear();
+	cut.Clear();
+	choices.Clear();
+}
+
+// Continuation passing search: a frame is the rest of a clause, and its parent is
+// the frame to resume when the clause is closed. The choice points of the open
+// literals are kept on an explicit stack, so the depth of the C++ stack does not
+// grow with the length of the proof. Returns true when the whole tableau is closed.
+bool ConnectionProver::Solve(int fi) {
+	int goal = fi;  // the frame to continue, -1 to backtrack
+	for(;;) {
+		if ((++steps & 1023) == 0 && ((opt.deadline && msecs(opt.deadline) >= 0) || (opt.cancel && *opt.cancel))) {
+			timeout = true;
+			return false;
+		}
+		if (goal >= 0) {
+			goal = Expand(goal);
+			if (goal == CLOSED)
+				return true;
+			if (goal >= 0)
+				continue;
+		}
+
+		// the last goal failed: try the next alternative of the innermost choice point
+		if (choices.IsEmpty())
+			return false;
+		ChoicePoint& cp = choices.Top();
+		Backtrack(cp.trail_mark, cp.cell_mark, cp.frame_mark, cp.slot_mark);
+		cut.Trim(cp.choice + 1);
+		goal = cut[cp.choice] ? -1 : NextAlternative(cp);
+		if (goal < 0)
+			choices.Drop();
+	}
+}
+
+// Closes the deterministic steps of a frame and returns the frame to continue,
+// CLOSED when the tableau is closed, or -1 when the frame fails. Otherwise the
+// literal gets a choice point and its first alternative is returned.
+int ConnectionProver::Expand(int fi) {
+	Frame f = frames[fi];
+	const Clause& c = cs.clauses[f.clause];
+
+	if (f.lit >= c.count) {
+		if (f.parent < 0)
+			return CLOSED;
+
+		// the literal of the parent frame is solved: it's a lemma for the rest of that clause
+		Frame p = frames[f.parent];
+		if (restricted)
+			cut[f.choice] = true;
+		const ClauseLiteral& solved = cs.GetLiteral(cs.clauses[p.clause], p.lit);
+		int lemmas = opt.lemmas ? Cons(solved.atom, p.off, solved.negative, p.lemmas) : p.lemmas;
+		return Advance(p, lemmas);
+	}
+
+	const ClauseLiteral& lit = cs.GetLiteral(c, f.lit);
+
+	// regularity
+	if (opt.regularity) {
+		for(int p = f.path; p >= 0; p = cells[p].next) {
+			const Cell& cell = cells[p];
+			if (cell.negative == lit.negative && Equal(lit.atom, f.off, cell.atom, cell.off))
+				return -1;
+		}
+	}
+
+	// lemma
+	if (opt.lemmas) {
+		for(int l = f.lemmas; l >= 0; l = cells[l].next) {
+			const Cell& cell = cells[l];
+			if (cell.negative == lit.negative && Equal(lit.atom, f.off, cell.atom, cell.off))
+				return Advance(f, f.lemmas);
+		}
+	}
+
+	ChoicePoint& cp = choices.Add();
+	cp.frame = fi;
+	cp.choice = cut.GetCount();
+	cut.Add(false);
+	cp.trail_mark = trail.GetCount();
+	cp.cell_mark = cells.GetCount();
+	cp.frame_mark = frames.GetCount();
+	cp.slot_mark = bindings.GetCount();
+	cp.reduction = f.path;
+	cp.extension = 0;
+	cp.occurrences = occurrences.Find(GetKey(cs.terms[lit.atom].symbol, !lit.negative));
+	cp.reduced = -1;
+
+	int next = NextAlternative(cp);
+	if (next < 0)
+		choices.Drop();
+	return next;
+}
+
+// Tries the remaining reductions and then the remaining extensions of a choice
+// point. Returns the frame to continue with the first one that unifies, or -1.
+int ConnectionProver::NextAlternative(ChoicePoint& cp) {
+	Frame f = frames[cp.frame];
+	const ClauseLiteral& lit = cs.GetLiteral(cs.clauses[f.clause], f.lit);
+	int symbol = cs.terms[lit.atom].symbol;
+
+	// reduction
+	while (cp.reduction >= 0) {
+		int p = cp.reduction;
+		cp.reduction = cells[p].next;
+		int atom = cells[p].atom;
+		int off = cells[p].off;
+		if (cells[p].negative == lit.negative || cs.terms[atom].symbol != symbol)
+			continue;
+
+		inferences++;
+		if (Unify(lit.atom, f.off, atom, off)) {
+			cp.reduced = p;
+			if (restricted)
+				cut[cp.choice] = true;
+			int lemmas = opt.lemmas ? Cons(lit.atom, f.off, lit.negative, f.lemmas) : f.lemmas;
+			return Advance(f, lemmas);
+		}
+		Backtrack(cp.trail_mark, cp.cell_mark, cp.frame_mark, cp.slot_mark);
+		cut.Trim(cp.choice + 1);
+		if (cut[cp.choice])
+			return -1;
+	}
+
+	// extension
+	cp.reduced = -1;
+	if (cp.occurrences < 0)
+		return -1;
+	const Vector<Occurrence>& occ = occurrences[cp.occurrences];
+
+	while (cp.extension < occ.GetCount()) {
+		const Occurrence& o = occ[cp.extension++];
+		const Clause& d = cs.clauses[o.clause];
+
+		if (f.path_len >= path_limit && d.var_count > 0) {
+			limit_hit = true;
+			continue;
+		}
+
+		inferences++;
+		int off = AllocSlots(d.var_count);
+		if (Unify(lit.atom, f.off, cs.GetLiteral(d, o.lit).atom, off)) {
+			Frame child;
+			child.clause = o.clause;
+			child.off = off;
+			child.copy = frames.GetCount();
+			child.skip = o.lit;
+			child.lit = NextLit(0, child.skip);
+			child.path = Cons(lit.atom, f.off, lit.negative, f.path, f.copy, f.lit);
+			child.path_len = f.path_len + 1;
+			child.lemmas = f.lemmas;
+			child.parent = cp.frame;
+			child.choice = cp.choice;
+			frames.Add(child);
+			return frames.GetCount() - 1;
+		}
+		Backtrack(cp.trail_mark, cp.cell_mark, cp.frame_mark, cp.slot_mark);
+		cut.Trim(cp.choice + 1);
+		if (cut[cp.choice])
+			return -1;
+	}
+
+	return -1;
+}
+
+// After a proof the frames and cells left are those of the closed tableau, and the
+// choice points are those of its open literals, with the alternative which closed them.
+void ConnectionProver::GetTableau(ConnectionResult& result) const {
+	Vector<int> copy_id;
+	copy_id.SetCount(frames.GetCount(), -1);
+	for(int i = 0; i < frames.GetCount(); i++) {
+		const Frame& f = frames[i];
+		if (f.copy != i)
+			continue;
+		copy_id[i] = result.copies.GetCount();
+		ConnectionCopy& c = result.copies.Add();
+		c.clause = f.clause;
+		c.off = f.off;
+		c.parent = f.parent < 0 ? -1 : copy_id[frames[f.parent].copy];
+		c.parent_lit = f.parent < 0 ? -1 : frames[f.parent].lit;
+		c.entry = f.parent < 0 ? -1 : f.skip;
+	}
+
+	for(int i = 0; i < choices.GetCount(); i++) {
+		const ChoicePoint& cp = choices[i];
+		if (cp.reduced < 0)
+			continue;
+		const Frame& f = frames[cp.frame];
+		const Cell& cell = cells[cp.reduced];
+		ConnectionReduction& r = result.reductions.Add();
+		r.copy = copy_id[f.copy];
+		r.lit = f.lit;
+		r.ancestor = copy_id[cell.copy];
+		r.ancestor_lit = cell.lit;
+	}
+
+	result.slot_term.SetCount(bindings.GetCount());
+	result.slot_off.SetCount(bindings.GetCount());
+	for(int i = 0; i < bindings.GetCount(); i++) {
+		result.slot_term[i] = bindings[i].term;
+		result.slot_off[i] = bindings[i].off;
+	}
+}
+
+ConnectionResult ConnectionProver::Prove() {
+	ConnectionResult result;
+	inferences = 0;
+	steps = 0;
+	timeout = false;
+
+	occurrences.Clear();
+	for(int i = 0; i < cs.clauses.GetCount(); i++) {
+		const Clause& c = cs.clauses[i];
+		for(int j = 0; j < c.count; j++) {
+			const ClauseLiteral& lit = cs.GetLiteral(c, j);
+			Occurrence& o = occurrences.GetAdd(GetKey(cs.terms[lit.atom].symbol, lit.negative)).Add();
+			o.clause = i;
+			o.lit = j;
+		}
+	}
+
+	// start clauses: the negated goal first, then the positive clauses
+	Vector<int> start;
+	for(int i = 0; i < cs.clauses.GetCount(); i++)
+		if (cs.clauses[i].conjecture)
+			start.Add(i);
+	for(int i = 0; i < cs.clauses.GetCount(); i++) {
+		const Clause& c = cs.clauses[i];
+		bool positive = !c.conjecture;
+		for(int j = 0; j < c.count && positive; j++)
+			if (cs.GetLiteral(c, j).negative)
+				positive = false;
+		if (positive)
+			start.Add(i);
+	}
+
+	// without a positive clause every atom can be false
+	if (start.IsEmpty()) {
+		result.exhausted = true;
+		return result;
+	}
+
+	for(path_limit = 1; path_limit <= opt.max_path; path_limit++) {
+		restricted = opt.restricted && path_limit < opt.complete_from;
+		limit_hit = false;
+		result.path_limit = path_limit;
+
+		for(int i = 0; i < start.GetCount(); i++) {
+			Reset();
+			Frame f;
+			f.clause = start[i];
+			f.off = AllocSlots(cs.clauses[start[i]].var_count);
+			f.copy = 0;
+			f.skip = -1;
+			f.lit = 0;
+			f.path = -1;
+			f.path_len = 0;
+			f.lemmas = -1;
+			f.parent = -1;
+			f.choice = -1;
+			frames.Add(f);
+
+			if (Solve(0)) {
+				result.proven = true;
+				result.inferences = inferences;
+				GetTableau(result);
+				return result;
+			}
+			if (timeout)
+				break;
+		}
+
+		if (timeout) {
+			result.timeout = true;
+			break;
+		}
+		if (!restricted && !limit_hit) {
+			result.exhausted = true;
+			break;
+		}
+	}
+
+	result.inferences = inferences;
+	return result;
+}
+
+ConnectionResult ProveConnection(const ClauseSet& clauses, const ConnectionOptions& opt) {
+	ConnectionProver prover(clauses, opt);
+	return prover.Prove();
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef _TheoremProver_Connection_h_
+#define _TheoremProver_Connection_h_
+
+namespace TheoremProver {
+
+/*
+	Connection tableau (leanCoP style) proof search over a ClauseSet.
+
+	The search is goal directed: it starts from a conjecture (or positive)
+	clause and closes every literal either by a reduction step against the
+	active path or by an extension step into a fresh copy of another clause.
+	Completeness comes from iterative deepening on the path length.
+*/
+
+struct ConnectionOptions {
+	int  max_path;       // upper limit of the iterative deepening
+	int  complete_from;  // path limit from which backtracking is not restricted
+	bool regularity;     // no literal may occur twice on a path
+	bool lemmas;         // reuse literals solved earlier in the same branch
+	bool restricted;     // don't retry alternatives of a literal that was solved once
+	int  deadline;       // msecs() at which the search gives up, 0 for no limit
+	const Atomic* cancel; // the search gives up when it is set, NULL for none
+
+	ConnectionOptions() : max_path(64), complete_from(7), regularity(true), lemmas(true), restricted(true), deadline(0), cancel(NULL) {}
+};
+
+// a clause copy of the closed tableau, which extends literal 'parent_lit' of copy
+// 'parent' through its literal 'entry'; the start clause has parent and entry -1
+struct ConnectionCopy : Moveable<ConnectionCopy> {
+	int clause, off;
+	int parent, parent_lit, entry;
+};
+
+// literal 'lit' of a copy closed by the complementary literal 'ancestor_lit' of a
+// copy on its path
+struct ConnectionReduction : Moveable<ConnectionReduction> {
+	int copy, lit;
+	int ancestor, ancestor_lit;
+};
+
+struct ConnectionResult {
+	bool proven;
+	bool exhausted;      // the complete search space was explored without a proof
+	bool timeout;
+	int  path_limit;
+	int64 inferences;    // attempted unifications
+
+	// the closed tableau of a proof: the literals which are neither extended nor
+	// reduced are closed by lemmas, and the variables of copy c are the slots from
+	// copies[c].off on, bound to slot_term/slot_off or -1
+	Vector<ConnectionCopy> copies;
+	Vector<ConnectionReduction> reductions;
+	Vector<int> slot_term, slot_off;
+
+	ConnectionResult() : proven(false), exhausted(false), timeout(false), path_limit(0), inferences(0) {}
+};
+
+ConnectionResult ProveConnection(const ClauseSet& clauses, const ConnectionOptions& opt = ConnectionOptions());
+
+}
+
+#endif
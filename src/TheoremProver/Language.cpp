@@ -2,9 +2,13 @@
 
 namespace TheoremProver {
 
-RefContext* GetContext() {
-	static RefContext ctx;
-	return &ctx;
+int InternSymbol(const String& name, int arity, bool predicate) {
+	static StaticMutex lock;
+	static Index<String> symbols;
+	String key;
+	key << (predicate ? 'P' : 'F') << arity << ':' << name;
+	Mutex::Lock __(lock);
+	return symbols.FindAdd(key);
 }
 
 NodeVar Node::GetDNF() {
@@ -18,6 +22,39 @@ NodeVar Node::Replace(Node& old, Node& new_) {
 	return this;
 }
 
+// Instantiation times are not copied
+NodeVar CopyNode(Node& n) {
+	if (dynamic_cast<Variable*>(&n))
+		return new Variable(n.GetName());
+	if (dynamic_cast<UnificationTerm*>(&n))
+		return new UnificationTerm(n.GetName());
+	
+	bool function = dynamic_cast<TheoremProver::Function*>(&n);
+	if (function || dynamic_cast<Predicate*>(&n)) {
+		Index<NodeVar> terms;
+		for(int i = 0; i < n.GetCount(); i++)
+			terms.Add(CopyNode(n[i]));
+		if (function)
+			return new TheoremProver::Function(n.GetName(), terms);
+		return new Predicate(n.GetName(), terms);
+	}
+	
+	if (dynamic_cast<Not*>(&n))
+		return new Not(*CopyNode(n[0]));
+	
+	if (n.GetCount() == 2) {
+		NodeVar a = CopyNode(n[0]);
+		NodeVar b = CopyNode(n[1]);
+		if (dynamic_cast<And*>(&n))         return new And(*a, *b);
+		if (dynamic_cast<Or*>(&n))          return new Or(*a, *b);
+		if (dynamic_cast<Implies*>(&n))     return new Implies(*a, *b);
+		if (dynamic_cast<ForAll*>(&n))      return new ForAll(*a, *b);
+		if (dynamic_cast<ThereExists*>(&n)) return new ThereExists(*a, *b);
+	}
+	
+	throw InvalidInputError("Can not copy node: " + n.ToString());
+}
+
 bool NodeVar::operator() (const NodeVar& a, const NodeVar& b) const {
 	// NOTE: this sort allows the same result than in python, even when it is a little bit silly
 	// TODO: right answer without silly sort. 
@@ -10,36 +10,41 @@ using RefCore::Ref;
 
 class NodeVar;
 class UnificationTerm;
+class Proof;
 
+// context of the nodes created on this thread, NULL if they are not registered
 RefContext* GetContext();
 
+// process wide id of a function or predicate symbol, the same on every thread
+int InternSymbol(const String& name, int arity, bool predicate);
+
 class Node : public Ref<Node> {
 	Node& operator=(const Node& n) {return *this;}
-	Node(const Node& n) : Ref<Node>(TheoremProver::GetContext()) {}
+	Node(const Node& n) : hash(0), Ref<Node>(TheoremProver::GetContext()) {}
 	
 protected:
 	friend class NodeVar;
 	
 	String name;
 	int time;
+	mutable uint32 hash;
 	
+	// structural hash of the node, cached by GetHashValue
+	virtual uint32 GetStructHash() const {return name.GetHashValue();}
 	
 public:
-	Node(const String& name) : name(name), time(0), Ref<Node>(TheoremProver::GetContext()) {}
-	Node() : time(0), Ref<Node>(TheoremProver::GetContext()) {}
-	virtual ~Node() {ASSERT(GetRefs() == 0);}
+	Node(const String& name) : name(name), time(0), hash(0), Ref<Node>(TheoremProver::GetContext()) {}
+	Node() : time(0), hash(0), Ref<Node>(TheoremProver::GetContext()) {}
+	virtual ~Node() {ASSERT(GetRefs() <= 0);}
 	
 	
 	String GetName() const {return name;}
 	int GetTime() const {return time;}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		return Index<NodeVar>();
-	}
-	
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		return Index<NodeVar>();
-	}
+	// the free variables and unification terms are added to 'out' in the
+	// order they occur, once for each occurrence
+	virtual void FreeVariables(Index<NodeVar>& out) {}
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {}
 
 	virtual bool operator==(Node& other) {
 		return false;
@@ -56,7 +61,7 @@ public:
 	}
 	
 	virtual String ToString() const {return name;}
-	virtual uint32 GetHashValue() const {return ToString().GetHashValue();}
+	virtual uint32 GetHashValue() const {if (!hash) hash = GetStructHash() | 1; return hash;}
 	
 	virtual String AsString(int ident=0) const {
 		String out;
@@ -68,6 +73,7 @@ public:
 	virtual bool Evaluate(const Index<String>& truth_assignment) const {return false;}
 	
 	virtual int GetCount() const {return 0;}
+	virtual int GetSymbol() const {return -1;}
 	virtual Node& operator[] (int i) {}
 	
 	virtual NodeVar GetDNF();
@@ -102,10 +108,8 @@ class Variable : public Node {
 public:
 	Variable(const String& name) : Node(name) {}
 
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
 		out.Add(NodeVar(this));
-		return out;
 	}
 
 	virtual bool operator==(Node& other) {
@@ -115,6 +119,10 @@ public:
 		return GetName() == other.GetName();
 	}
 	
+	virtual uint32 GetStructHash() const {
+		return CombineHash(1, name.GetHashValue());
+	}
+	
 	virtual String AsString(int ident=0) const {
 		String out;
 		for(int i = 0; i < ident; i++) out.Cat('\t');
@@ -132,10 +140,8 @@ public:
 		
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		Index<NodeVar> out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
 		out.Add(NodeVar(this));
-		return out;
 	}
 
 	virtual bool Occurs(UnificationTerm& unification_term) {
@@ -149,6 +155,10 @@ public:
 		return GetName() == other.GetName();
 	}
 	
+	virtual uint32 GetStructHash() const {
+		return CombineHash(2, name.GetHashValue());
+	}
+	
 	virtual String AsString(int ident=0) const {
 		String out;
 		for(int i = 0; i < ident; i++) out.Cat('\t');
@@ -161,38 +171,31 @@ public:
 class Function : public Node {
 	
 protected:
-	friend ArrayMap<NodeVar, NodeVar> Unify(Node& term_a, Node& term_b);
+	friend bool Unify(Node& term_a, Node& term_b, VectorMap<NodeVar, NodeVar>& out);
 	friend void TypecheckTerm ( Node& term );
 	
 	Index<NodeVar> terms;
+	mutable int symbol;  // interned on first use, like the hash
 	
 public:
-	Function(const String& name, const Index<NodeVar>& terms) : Node(name) {
+	Function(const String& name, const Index<NodeVar>& terms) : Node(name), symbol(-1) {
 		this->terms <<= terms;
 	}
 	
 	virtual int GetCount() const {return terms.GetCount();}
+	virtual int GetSymbol() const {if (symbol < 0) symbol = InternSymbol(name, terms.GetCount(), false); return symbol;}
 	virtual Node& operator[] (int i) {return *terms[i];}
+	virtual void GetReferences(Vector<RefBase*>& out) {for(int i = 0; i < terms.GetCount(); i++) out.Add(terms[i].GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		if (terms.GetCount() == 0)
-			return Index<NodeVar>();
-		
-		Index<NodeVar> out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
 		for(int i = 0; i < terms.GetCount(); i++)
-			Append(out, terms[i]->FreeVariables());
-		return out;
+			terms[i]->FreeVariables(out);
 		//return reduce((lambda x, y: x | y), [term.FreeVariables() for term in terms]);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		if (terms.GetCount() == 0)
-			return Index<NodeVar>();
-
-		Index<NodeVar> out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
 		for(int i = 0; i < terms.GetCount(); i++)
-			Append(out, terms[i]->FreeUnificationTerms());
-		return out;
+			terms[i]->FreeUnificationTerms(out);
 		//return reduce((lambda x, y: x | y), [term.FreeUnificationTerms() for term in terms]);
 	}
 
@@ -236,7 +239,6 @@ public:
 		if (terms.GetCount() != fn->terms.GetCount())
 			return false;
 		
-		if (!terms.GetCount()) return false;
 		for(int i = 0; i < terms.GetCount(); i++) {
 			if (!(*terms[i] == *fn->terms[i]))
 				return false;
@@ -245,6 +247,13 @@ public:
 		//return all([terms[i] == other.terms[i] for i in range(terms.GetCount())]);
 	}
 
+	virtual uint32 GetStructHash() const {
+		CombineHash h(3, name.GetHashValue());
+		for(int i = 0; i < terms.GetCount(); i++)
+			h.Put(terms[i]->GetHashValue());
+		return h;
+	}
+	
 	virtual String ToString() const {
 		if (terms.GetCount() == 0)
 			return GetName();
@@ -282,42 +291,35 @@ public:
 class Predicate : public Node {
 	
 protected:
-	friend ArrayMap<NodeVar, NodeVar> Unify(Node& term_a, Node& term_b);
+	friend bool Unify(Node& term_a, Node& term_b, VectorMap<NodeVar, NodeVar>& out);
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	
 	Index<NodeVar> terms;
+	mutable int symbol;  // interned on first use, like the hash
 	
 public:
 
-	Predicate(const String& name, const Index<NodeVar>& terms) : Node(name) {
+	Predicate(const String& name, const Index<NodeVar>& terms) : Node(name), symbol(-1) {
 		this->terms <<= terms;
 		for(int i = 0; i < terms.GetCount(); i++) {ASSERT(terms[i].GetNode());}
 	}
 	
 	virtual int GetCount() const {return terms.GetCount();}
+	virtual int GetSymbol() const {if (symbol < 0) symbol = InternSymbol(name, terms.GetCount(), true); return symbol;}
 	virtual Node& operator[] (int i) {return *terms[i];}
+	virtual void GetReferences(Vector<RefBase*>& out) {for(int i = 0; i < terms.GetCount(); i++) out.Add(terms[i].GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		if (terms.GetCount() == 0)
-			return Index<NodeVar>();
-
-		Index<NodeVar> out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
 		for(int i = 0; i < terms.GetCount(); i++)
-			Append(out, terms[i]->FreeVariables());
-		return out;
+			terms[i]->FreeVariables(out);
 		//return reduce((lambda x, y: x | y), [term.FreeVariables() for term in terms]);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		if (terms.GetCount() == 0)
-			return Index<NodeVar>();
-
-		Index<NodeVar> out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
 		for(int i = 0; i < terms.GetCount(); i++)
-			Append(out, terms[i]->FreeUnificationTerms());
-		return out;
+			terms[i]->FreeUnificationTerms(out);
 		//return reduce((lambda x, y: x | y), [term.FreeUnificationTerms() for term in terms]);
 	}
 
@@ -352,7 +354,6 @@ public:
 		if (terms.GetCount() != pr->terms.GetCount())
 			return false;
 		
-		if (!terms.GetCount()) return false;
 		for(int i = 0; i < terms.GetCount(); i++) {
 			if (!(*terms[i] == *pr->terms[i]))
 				return false;
@@ -367,6 +368,13 @@ public:
 			terms[i]->SetInstantiationTime(time);
 	}
 
+	virtual uint32 GetStructHash() const {
+		CombineHash h(4, name.GetHashValue());
+		for(int i = 0; i < terms.GetCount(); i++)
+			h.Put(terms[i]->GetHashValue());
+		return h;
+	}
+	
 	virtual String ToString() const {
 		if (terms.GetCount() == 0)
 			return GetName();
@@ -409,7 +417,7 @@ class Not : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar formula;
 
@@ -421,13 +429,14 @@ public:
 	
 	virtual int GetCount() const {return 1;}
 	virtual Node& operator[] (int i) {if (i == 0) return *formula;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(formula.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		return formula->FreeVariables();
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		formula->FreeVariables(out);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		return formula->FreeUnificationTerms();
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -455,6 +464,10 @@ public:
 		return *formula == *no->formula;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(5, formula->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return "¬" + formula->ToString();
 	}
@@ -482,7 +495,7 @@ class And : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar formula_a, formula_b;
 	
@@ -494,19 +507,16 @@ public:
 	
 	virtual int GetCount() const {return 2;}
 	virtual Node& operator[] (int i) {if (i == 0) return *formula_a; if (i == 1) return *formula_b;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(formula_a.GetNode()); out.Add(formula_b.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeVariables());
-		Append(out, formula_b->FreeVariables());
-		return out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		formula_a->FreeVariables(out);
+		formula_b->FreeVariables(out);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeUnificationTerms());
-		Append(out, formula_b->FreeUnificationTerms());
-		return out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula_a->FreeUnificationTerms(out);
+		formula_b->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -538,6 +548,10 @@ public:
 		return *formula_a == *an->formula_a && *formula_b == *an->formula_b;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(6, formula_a->GetHashValue()).Put(formula_b->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return Format("(%s ∧ %s)", formula_a->ToString(), formula_b->ToString());
 	}
@@ -565,7 +579,7 @@ class Or : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar formula_a, formula_b;
 	
@@ -577,19 +591,16 @@ public:
 	
 	virtual int GetCount() const {return 2;}
 	virtual Node& operator[] (int i) {if (i == 0) return *formula_a; if (i == 1) return *formula_b;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(formula_a.GetNode()); out.Add(formula_b.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeVariables());
-		Append(out, formula_b->FreeVariables());
-		return out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		formula_a->FreeVariables(out);
+		formula_b->FreeVariables(out);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeUnificationTerms());
-		Append(out, formula_b->FreeUnificationTerms());
-		return out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula_a->FreeUnificationTerms(out);
+		formula_b->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -621,6 +632,10 @@ public:
 		return *formula_a == *or_->formula_a && *formula_b == *or_->formula_b;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(7, formula_a->GetHashValue()).Put(formula_b->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return Format("(%s ∨ %s)", formula_a->ToString(), formula_b->ToString());
 	}
@@ -648,7 +663,7 @@ class Implies : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar formula_a, formula_b;
 	
@@ -660,19 +675,16 @@ public:
 	
 	virtual int GetCount() const {return 2;}
 	virtual Node& operator[] (int i) {if (i == 0) return *formula_a; if (i == 1) return *formula_b;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(formula_a.GetNode()); out.Add(formula_b.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeVariables());
-		Append(out, formula_b->FreeVariables());
-		return out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		formula_a->FreeVariables(out);
+		formula_b->FreeVariables(out);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		Index<NodeVar> out;
-		Append(out, formula_a->FreeUnificationTerms());
-		Append(out, formula_b->FreeUnificationTerms());
-		return out;
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula_a->FreeUnificationTerms(out);
+		formula_b->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -703,6 +715,10 @@ public:
 		return *formula_a == *implies->formula_a && *formula_b == *implies->formula_b;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(8, formula_a->GetHashValue()).Put(formula_b->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return Format("(%s → %s)", formula_a->ToString(), formula_b->ToString());
 	}
@@ -728,11 +744,23 @@ public:
 	
 };
 
+// adds the free variables of the body of a quantifier to 'out', less the
+// first occurrence of the bound variable
+inline void AddUnboundVariables(Index<NodeVar>& out, const NodeVar& variable, const NodeVar& formula) {
+	int begin = out.GetCount();
+	formula->FreeVariables(out);
+	for(int i = begin; i < out.GetCount(); i++)
+		if (out[i] == variable) {
+			out.Remove(i);
+			break;
+		}
+}
+
 class ForAll : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar variable, formula;
 	
@@ -744,16 +772,14 @@ public:
 	
 	virtual int GetCount() const {return 2;}
 	virtual Node& operator[] (int i) {if (i == 0) return *variable; if (i == 1) return *formula;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(variable.GetNode()); out.Add(formula.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out = formula->FreeVariables();
-		int i = out.Find(variable);
-		if (i != -1) out.Remove(i);
-		return out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		AddUnboundVariables(out, variable, formula);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		return formula->FreeUnificationTerms();
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -784,6 +810,10 @@ public:
 		return *variable == *forall->variable && *formula == *forall->formula;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(9, variable->GetHashValue()).Put(formula->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return Format("(∀%s. %s)", variable->ToString(), formula->ToString());
 	}
@@ -807,7 +837,7 @@ class ThereExists : public Node {
 	
 protected:
 	friend void TypecheckFormula ( Node& formula );
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	NodeVar variable, formula;
 	
@@ -819,17 +849,15 @@ public:
 	
 	virtual int GetCount() const {return 2;}
 	virtual Node& operator[] (int i) {if (i == 0) return *variable; if (i == 1) return *formula;}
+	virtual void GetReferences(Vector<RefBase*>& out) {out.Add(variable.GetNode()); out.Add(formula.GetNode());}
 	
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> out = formula->FreeVariables();
-		int i = out.Find(variable);
-		if (i != -1) out.Remove(i);
-		return out;
+	virtual void FreeVariables(Index<NodeVar>& out) {
+		AddUnboundVariables(out, variable, formula);
 		//return formula->FreeVariables() - { variable };
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		return formula->FreeUnificationTerms();
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
+		formula->FreeUnificationTerms(out);
 	}
 
 	virtual NodeVar Replace(Node& old, Node& new_) {
@@ -860,6 +888,10 @@ public:
 		return *variable == *there_exists->variable && *formula == *there_exists->formula;
 	}
 
+	virtual uint32 GetStructHash() const {
+		return CombineHash(10, variable->GetHashValue()).Put(formula->GetHashValue());
+	}
+	
 	virtual String ToString() const {
 		return Format("(∃%s. %s)", variable->ToString(), formula->ToString());
 	}
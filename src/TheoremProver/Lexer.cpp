@@ -0,0 +1,155 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+
+static const char* symbol_names[SYM_NAME] = {
+	"not", "and", "or", "implies", "equals", "forall", "exists", "(", ")", ",", "."
+};
+
+static bool IsAlphaNumber(int chr) {return IsAlpha ( chr ) || IsDigit ( chr );}
+
+static inline uint32 HashChar(uint32 hash, int chr) {return (hash ^ (byte)chr) * 16777619U;}
+
+// returns the id of the keyword spelled by a word or -1
+static int FindKeyword(const char* s, int len) {
+	if (len < 2 || len > 7)
+		return -1;
+
+	for (int id = SYM_NOT; id <= SYM_EXISTS; id++) {
+		const char* name = symbol_names[id];
+		int i = 0;
+		if (id == SYM_EQUALS)
+			while (i < len && s[i] == name[i])
+				i++;
+		else
+			while (i < len && ToLower(s[i]) == name[i])
+				i++;
+		if (i == len && name[i] == 0)
+			return id;
+	}
+	return -1;
+}
+
+const String& TokenList::GetName(int symbol) const {
+	static const String fixed[SYM_NAME] = {
+		symbol_names[0], symbol_names[1], symbol_names[2], symbol_names[3],
+		symbol_names[4], symbol_names[5], symbol_names[6], symbol_names[7],
+		symbol_names[8], symbol_names[9], symbol_names[10]
+	};
+	if (symbol < SYM_NAME)
+		return fixed[symbol];
+	return names[symbol - SYM_NAME];
+}
+
+void TokenList::Lex(const String& inp) {
+	source = inp;
+	Lex(source.Begin(), source.GetCount());
+}
+
+void TokenList::Lex(const char* s, int count) {
+	text = s;
+	tokens.SetCount(0);
+	int pos = 0;
+
+	while ( pos < count ) {
+		int chr = s[pos];
+
+		// skip whitespace
+		if ( chr == ' ' || chr == '\t' ) {
+			pos += 1;
+			continue;
+		}
+
+		Token& t = tokens.Add();
+		t.begin = pos;
+
+		// identifiers
+		if ( IsAlphaNumber(chr) ) {
+			uint32 hash = 2166136261U;
+			bool lower = true, upper = false;
+			do {
+				lower = lower && Upp::IsLower(chr);
+				upper = upper || Upp::IsUpper(chr);
+				hash = HashChar(hash, chr);
+				pos += 1;
+			}
+			while ( pos < count && IsAlphaNumber(chr = s[pos]) );
+
+			t.len = pos - t.begin;
+			t.symbol = FindKeyword(s + t.begin, t.len);
+			if ( t.symbol >= 0 )
+				t.kind = TOKEN_KEYWORD;
+			else {
+				t.kind = lower ? TOKEN_LOWER : upper ? TOKEN_UPPER : TOKEN_WORD;
+				t.symbol = Intern(s + t.begin, t.len, hash);
+			}
+			continue;
+		}
+
+		// symbols
+		t.len = 1;
+		t.kind = TOKEN_PUNCT;
+		pos += 1;
+		switch ( chr ) {
+		case '(': t.symbol = SYM_LPAREN; break;
+		case ')': t.symbol = SYM_RPAREN; break;
+		case ',': t.symbol = SYM_COMMA; break;
+		case '.': t.symbol = SYM_DOT; break;
+		default:
+			t.kind = TOKEN_SYMBOL;
+			t.symbol = Intern(s + t.begin, 1, HashChar(2166136261U, chr));
+		}
+	}
+}
+
+int TokenList::Intern(const char* name) {
+	uint32 hash = 2166136261U;
+	int len = 0;
+	for (; name[len]; len++)
+		hash = HashChar(hash, name[len]);
+	return Intern(name, len, hash);
+}
+
+int TokenList::Intern(const char* s, int len, uint32 hash) {
+	if (2 * names.GetCount() >= slots.GetCount())
+		Rehash(max(16, 2 * slots.GetCount()));
+
+	int mask = slots.GetCount() - 1;
+	for (int i = hash & mask;; i = (i + 1) & mask) {
+		int j = slots[i];
+		if (j < 0) {
+			j = names.GetCount();
+			slots[i] = j;
+			names.Add(String(s, len));
+			hashes.Add(hash);
+			return SYM_NAME + j;
+		}
+		const String& name = names[j];
+		if (hashes[j] == hash && name.GetCount() == len && memcmp(name.Begin(), s, len) == 0)
+			return SYM_NAME + j;
+	}
+}
+
+void TokenList::Rehash(int count) {
+	slots.Clear();
+	slots.SetCount(count, -1);
+	int mask = count - 1;
+	for (int j = 0; j < hashes.GetCount(); j++) {
+		int i = hashes[j] & mask;
+		while (slots[i] >= 0)
+			i = (i + 1) & mask;
+		slots[i] = j;
+	}
+}
+
+void TokenList::Clear() {
+	source.Clear();
+	text = NULL;
+	tokens.Clear();
+	names.Clear();
+	hashes.Clear();
+	slots.Clear();
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef _TheoremProver_Lexer_h_
+#define _TheoremProver_Lexer_h_
+
+namespace TheoremProver {
+
+/*
+	Formula lexer.
+
+	TokenList splits a formula into tokens without copying its text. A token
+	is its kind, a symbol id and its span in the source. The keywords and
+	the punctuation of the grammar have the fixed ids below, so the parser
+	compares integers only. Every other word or character is interned in the
+	list, which keeps one copy of each distinct name for all the nodes built
+	from it. The names stay interned when the list lexes another formula.
+	A formula lexed from a block of memory is not copied at all: the block
+	must stay valid as long as the tokens are used.
+
+	Keywords are case insensitive, except "equals": "Equals" and "EQUALS"
+	are predicates.
+*/
+
+enum {
+	TOKEN_KEYWORD,
+	TOKEN_PUNCT,     // "(", ")", "," or "."
+	TOKEN_LOWER,     // lower case word: variable or function
+	TOKEN_UPPER,     // word with an upper case letter: predicate
+	TOKEN_WORD,      // any other alphanumeric word
+	TOKEN_SYMBOL     // any other character
+};
+
+enum {
+	SYM_NOT,
+	SYM_AND,
+	SYM_OR,
+	SYM_IMPLIES,
+	SYM_EQUALS,
+	SYM_FORALL,
+	SYM_EXISTS,
+	SYM_LPAREN,
+	SYM_RPAREN,
+	SYM_COMMA,
+	SYM_DOT,
+	SYM_NAME         // the first interned name
+};
+
+struct Token : Moveable<Token> {
+	int kind;
+	int symbol;
+	int begin, len;  // span in the source
+};
+
+class TokenList {
+	String         source;  // owns the text lexed from a String
+	const char*    text;
+	Vector<Token>  tokens;
+	Vector<String> names;
+	Vector<uint32> hashes;
+	Vector<int>    slots;   // open addressing table of names, -1 if free
+
+	int  Intern(const char* s, int len, uint32 hash);
+	void Rehash(int count);
+
+public:
+	void Lex(const String& inp);
+	void Lex(const char* s, int len);
+	void Clear();
+	int  Intern(const char* name);  // the symbol id of a word that is not a keyword
+
+	int           GetCount() const            {return tokens.GetCount();}
+	const Token&  operator[](int i) const     {return tokens[i];}
+	String        GetText(int i) const        {return String(text + tokens[i].begin, tokens[i].len);}
+	const String& GetName(int symbol) const;
+	int           GetNameCount() const        {return names.GetCount();}
+
+	TokenList() : text(NULL) {}
+
+};
+
+}
+
+#endif
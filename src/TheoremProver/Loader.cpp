@@ -0,0 +1,136 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+enum {
+	LOAD_CHUNK = 1024 * 1024  // least bytes per worker
+};
+
+struct LoadChunk {
+	const char*     begin;
+	const char*     end;
+	RefContext      region;
+	Vector<NodeVar> axioms;
+	int             line;     // the line of an error, counted from the chunk
+	String          error;
+};
+
+static bool IsBlank(int chr) {return chr == ' ' || chr == '\t' || chr == '\r';}
+
+// parses the statements of the lines from 'begin' to 'end', the first of
+// which is 'line', and leaves 'line' at the line of an error
+static void ParseAxioms(const char* begin, const char* end, int& line, Vector<NodeVar>& out) {
+	TokenList tokens;
+	int axiom = tokens.Intern("axiom");
+	
+	for ( const char* from = begin; from < end; line++ ) {
+		const char* eol = (const char*)memchr(from, '\n', end - from);
+		if (!eol)
+			eol = end;
+		const char* to = eol;
+		while (from < to && IsBlank(*from))
+			from++;
+		while (to > from && IsBlank(to[-1]))
+			to--;
+		
+		if (from < to && *from != '#' && *from != '%') {
+			tokens.Lex(from, (int)(to - from));
+			int first = tokens[0].symbol == axiom ? 1 : 0;
+			NodeVar formula = Parse(tokens, first);
+			CheckFormula ( *formula );
+			out.Add(formula);
+		}
+		from = eol + 1;
+	}
+}
+
+static int CountLines(const char* begin, const char* end) {
+	int count = 0;
+	while ((begin = (const char*)memchr(begin, '\n', end - begin)) != NULL) {
+		count++;
+		begin++;
+	}
+	return count;
+}
+
+// parses a chunk into its region, or into free nodes if the nodes of the
+// caller are free
+static void ParseChunk(LoadChunk& c, RefContext* ctx) {
+	FreeNodeScope free_scope;
+	RegionScope region_scope(ctx ? &c.region : NULL);
+	try {
+		ParseAxioms(c.begin, c.end, c.line, c.axioms);
+	}
+	catch (InvalidInputError e) {
+		c.error = e;
+	}
+}
+
+// Every chunk starts at a line and is parsed by a worker. The regions are
+// moved to the context of the caller when all the chunks are parsed, so a
+// file with an error leaves no node there.
+static void ParseChunks(const char* begin, const char* end, const String& path, int threads, Vector<NodeVar>& out) {
+	Array<LoadChunk> chunks;
+	const char* from = begin;
+	for(int i = 1; i <= threads && from < end; i++) {
+		const char* to = i == threads ? end : begin + (end - begin) * i / threads;
+		if (to < from)
+			to = from;
+		to = (const char*)memchr(to, '\n', end - to);
+		to = to ? to + 1 : end;
+		LoadChunk& c = chunks.Add();
+		c.begin = from;
+		c.end = to;
+		c.line = 0;
+		from = to;
+	}
+	
+	RefContext* ctx = GetContext();
+	if (chunks.GetCount() == 1)
+		ParseChunk(chunks[0], ctx);
+	else {
+		CoWork co;
+		for(int i = 0; i < chunks.GetCount(); i++) {
+			LoadChunk& c = chunks[i];
+			co & [&c, ctx] {ParseChunk(c, ctx);};
+		}
+		co.Finish();
+	}
+	
+	for(int i = 0; i < chunks.GetCount(); i++) {
+		LoadChunk& c = chunks[i];
+		if (c.error.GetCount())
+			throw InvalidInputError ( Format( "%s:%d: %s", path, CountLines(begin, c.begin) + c.line + 1, c.error ) );
+	}
+	
+	for(int i = 0; i < chunks.GetCount(); i++) {
+		LoadChunk& c = chunks[i];
+		if (ctx)
+			ctx->Adopt(c.region);
+		out.AppendPick(pick(c.axioms));
+	}
+}
+
+int LoadAxiomFile(const String& path, int threads) {
+	FileMapping map;
+	if (!map.Open(path))
+		throw InvalidInputError ( Format( "Unable to open %s.", path ) );
+	
+	Vector<NodeVar> axioms;
+	int64 size = map.GetFileSize();
+	if (size > 0) {
+		const char* begin = (const char*)map.Map();
+		if (!begin)
+			throw InvalidInputError ( Format( "Unable to open %s.", path ) );
+		
+		if (threads <= 0)
+			threads = CPU_Cores();
+		threads = (int)max((int64)1, min((int64)threads, size / LOAD_CHUNK));
+		ParseChunks(begin, begin + size, path, threads, axioms);
+	}
+	
+	GetSession().AddAxioms(axioms);
+	return axioms.GetCount();
+}
+
+}
@@ -0,0 +1,32 @@
+#ifndef _TheoremProver_Loader_h_
+#define _TheoremProver_Loader_h_
+
+namespace TheoremProver {
+
+/*
+	Axiom file loader.
+
+	Loads a knowledge base of one formula per line, with or without the
+	"axiom" command before it. Lines starting with # or % are comments. The
+	file is mapped into memory and lexed a line at a time in place, so no
+	line is copied, and the names of the axioms are interned once per chunk.
+
+	A large file is split at lines into one chunk per thread, and the chunks
+	are parsed at the same time. Every worker allocates its nodes from the
+	pool of its thread and registers them in a region of its own, which is
+	moved to the context of the caller when all of them are done, so the
+	workers never share a node or a lock. The nodes of the chunks are not
+	deduplicated: there is no hash consing of nodes, and a file loaded by one
+	thread keeps its duplicate axioms as well.
+
+	The axioms are added to the session of the calling thread when the whole
+	file is parsed, with one index build, in the order "axiom" commands for
+	the lines would give them. A file with an error adds no axiom.
+*/
+
+// Returns the number of axioms added. 'threads' is 0 for one per core.
+int LoadAxiomFile(const String& path, int threads = 0);
+
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+static String ElementToString(int e) {
+	return "e" + IntStr(e);
+}
+
+static String TupleToString(int tuple, int arity, int size) {
+	if (arity == 0)
+		return "";
+	String s = "(";
+	for(int i = 0; i < arity; i++) {
+		if (i) s << ", ";
+		s << ElementToString(tuple % size);
+		tuple /= size;
+	}
+	s << ")";
+	return s;
+}
+
+String FiniteModel::ToString() const {
+	String s = Format("Countermodel of size %d:", size);
+	for(int i = 0; i < names.GetCount(); i++) {
+		const Vector<int>& t = table[i];
+		for(int j = 0; j < t.GetCount(); j++) {
+			s << "\n  " << names[i] << TupleToString(j, arity[i], size) << " = ";
+			if (predicate[i])
+				s << (t[j] ? "true" : "false");
+			else
+				s << ElementToString(t[j]);
+		}
+	}
+	return s;
+}
+
+
+// Flattening and grounding
+
+class ModelFinder {
+
+	// every argument is a variable; functions have the result variable last
+	struct FlatLiteral : Moveable<FlatLiteral> {
+		int symbol;
+		bool negative;
+		Vector<int> vars;
+	};
+
+	struct FlatClause : Moveable<FlatClause> {
+		Vector<FlatLiteral> literals;
+		int var_count;
+	};
+
+	const ClauseSet& cs;
+	ModelOptions opt;
+	Vector<FlatClause> flat;
+
+	int size;
+	Vector<int> base;
+
+	int  FlattenTerm(int term, FlatClause& fc, Vector<int>& done, Vector<int>& done_vars);
+	void Flatten(int clause);
+	int  GetRelArity(int symbol) const;
+	int  GetAtom(int symbol, const Vector<int>& tuple) const;
+	bool Ground(SatSolver& sat);
+	void Extract(const SatSolver& sat, FiniteModel& model);
+	bool IsCanceled() const {return (opt.deadline && msecs(opt.deadline) >= 0) || (opt.cancel && *opt.cancel);}
+
+public:
+	ModelFinder(const ClauseSet& cs, const ModelOptions& opt) : cs(cs), opt(opt), size(0) {}
+
+	bool Find(FiniteModel& model);
+
+};
+
+int ModelFinder::FlattenTerm(int term, FlatClause& fc, Vector<int>& done, Vector<int>& done_vars) {
+	if (cs.IsVariable(term))
+		return cs.terms[term].var;
+
+	for(int i = 0; i < done.GetCount(); i++)
+		if (cs.IsSame(done[i], term))
+			return done_vars[i];
+
+	const ClauseTerm& t = cs.terms[term];
+	FlatLiteral lit;
+	lit.symbol = t.symbol;
+	lit.negative = true;
+	for(int i = 0; i < t.count; i++)
+		lit.vars.Add(FlattenTerm(cs.GetArg(term, i), fc, done, done_vars));
+
+	int result = fc.var_count++;
+	lit.vars.Add(result);
+	fc.literals.Add(pick(lit));
+
+	done.Add(term);
+	done_vars.Add(result);
+	return result;
+}
+
+void ModelFinder::Flatten(int clause) {
+	const Clause& c = cs.clauses[clause];
+	FlatClause& fc = flat.Add();
+	fc.var_count = c.var_count;
+
+	Vector<int> done, done_vars;
+	for(int i = 0; i < c.count; i++) {
+		const ClauseLiteral& cl = cs.GetLiteral(c, i);
+		int atom = cl.atom;
+		Vector<int> vars;
+		for(int j = 0; j < cs.terms[atom].count; j++)
+			vars.Add(FlattenTerm(cs.GetArg(atom, j), fc, done, done_vars));
+
+		FlatLiteral& lit = fc.literals.Add();
+		lit.symbol = cs.terms[atom].symbol;
+		lit.negative = cl.negative;
+		lit.vars = pick(vars);
+	}
+}
+
+int ModelFinder::GetRelArity(int symbol) const {
+	return cs.arity[symbol] + (cs.predicate[symbol] ? 0 : 1);
+}
+
+int ModelFinder::GetAtom(int symbol, const Vector<int>& tuple) const {
+	int index = 0, mul = 1;
+	for(int i = 0; i < tuple.GetCount(); i++) {
+		index += tuple[i] * mul;
+		mul *= size;
+	}
+	return base[symbol] + index;
+}
+
+// n^k, or limit + 1 when it is larger than the limit
+static int64 Power(int64 n, int k, int64 limit = INT64_MAX - 1) {
+	int64 r = 1;
+	for(int i = 0; i < k; i++) {
+		if (r > limit / n)
+			return limit + 1;
+		r *= n;
+	}
+	return r;
+}
+
+// false when the size needs more ground clauses or variables than the
+// options allow; a larger size needs even more, so the search ends there
+bool ModelFinder::Ground(SatSolver& sat) {
+	int64 total = 0;
+	for(int i = 0; i < flat.GetCount(); i++) {
+		total += Power(size, flat[i].var_count, opt.max_ground_clauses);
+		if (total > opt.max_ground_clauses)
+			return false;
+	}
+
+	int64 vars = 0;
+	for(int i = 0; i < cs.symbols.GetCount(); i++) {
+		vars += Power(size, GetRelArity(i), opt.max_ground_vars);
+		if (vars > opt.max_ground_vars)
+			return false;
+	}
+
+	base.SetCount(cs.symbols.GetCount());
+	for(int i = 0; i < cs.symbols.GetCount(); i++) {
+		int count = (int)Power(size, GetRelArity(i));
+		base[i] = sat.GetVarCount();
+		for(int j = 0; j < count; j++)
+			sat.NewVar();
+	}
+
+	Vector<int> lits, tuple, assign;
+	int64 added = 0;
+
+	for(int i = 0; i < flat.GetCount(); i++) {
+		const FlatClause& fc = flat[i];
+		assign.SetCount(fc.var_count);
+		for(int j = 0; j < assign.GetCount(); j++)
+			assign[j] = 0;
+
+		while (true) {
+			lits.SetCount(0);
+			for(int j = 0; j < fc.literals.GetCount(); j++) {
+				const FlatLiteral& fl = fc.literals[j];
+				tuple.SetCount(fl.vars.GetCount());
+				for(int k = 0; k < tuple.GetCount(); k++)
+					tuple[k] = assign[fl.vars[k]];
+				lits.Add(SatLit(GetAtom(fl.symbol, tuple), fl.negative));
+			}
+			if (!sat.AddClause(lits))
+				return true;
+			if ((++added & 4095) == 0 && IsCanceled())
+				return false;
+
+			int k = 0;
+			while (k < assign.GetCount() && ++assign[k] == size)
+				assign[k++] = 0;
+			if (k == assign.GetCount())
+				break;
+		}
+	}
+
+	// functions are total and functional
+	int constants = 0;
+	for(int s = 0; s < cs.symbols.GetCount(); s++) {
+		if (cs.predicate[s])
+			continue;
+
+		int arity = cs.arity[s];
+		int rows = (int)Power(size, arity);
+		for(int r = 0; r < rows; r++) {
+			int first = base[s] + r;
+			int step = rows;
+
+			lits.SetCount(0);
+			for(int y = 0; y < size; y++)
+				lits.Add(SatLit(first + y * step, false));
+			sat.AddClause(lits);
+
+			for(int y1 = 0; y1 < size; y1++) {
+				for(int y2 = y1 + 1; y2 < size; y2++) {
+					lits.SetCount(0);
+					lits.Add(SatLit(first + y1 * step, true));
+					lits.Add(SatLit(first + y2 * step, true));
+					sat.AddClause(lits);
+				}
+			}
+		}
+
+		// symmetry breaking: the i:th constant is one of the first i+1 elements, and it
+		// may take a new element only if the previous constants have taken the one before
+		if (arity == 0) {
+			int i = constants++;
+			for(int d = i + 1; d < size; d++) {
+				lits.SetCount(0);
+				lits.Add(SatLit(base[s] + d, true));
+				sat.AddClause(lits);
+			}
+			for(int d = 1; d <= i && d < size; d++) {
+				lits.SetCount(0);
+				lits.Add(SatLit(base[s] + d, true));
+				for(int t = 0; t < s; t++)
+					if (!cs.predicate[t] && cs.arity[t] == 0)
+						lits.Add(SatLit(base[t] + d - 1, false));
+				sat.AddClause(lits);
+			}
+		}
+	}
+
+	return true;
+}
+
+void ModelFinder::Extract(const SatSolver& sat, FiniteModel& model) {
+	model.size = size;
+	model.names.Clear();
+	model.arity.Clear();
+	model.predicate.Clear();
+	model.table.Clear();
+
+	for(int s = 0; s < cs.symbols.GetCount(); s++) {
+		model.names.Add(cs.names[s]);
+		model.arity.Add(cs.arity[s]);
+		model.predicate.Add(cs.predicate[s]);
+		Vector<int>& t = model.table.Add();
+
+		int rows = (int)Power(size, cs.arity[s]);
+		for(int r = 0; r < rows; r++) {
+			if (cs.predicate[s]) {
+				t.Add(sat.GetValue(base[s] + r));
+				continue;
+			}
+			int value = 0;
+			for(int y = 0; y < size; y++)
+				if (sat.GetValue(base[s] + r + y * rows))
+					value = y;
+			t.Add(value);
+		}
+	}
+}
+
+bool ModelFinder::Find(FiniteModel& model) {
+	for(int i = 0; i < cs.clauses.GetCount(); i++)
+		Flatten(i);
+
+	for(size = 1; size <= opt.max_size; size++) {
+		if (IsCanceled())
+			return false;
+		SatSolver sat;
+		if (!Ground(sat))
+			return false;
+		int result = sat.Solve(opt.conflict_limit, opt.deadline, opt.cancel);
+		if (result == SAT_TRUE) {
+			Extract(sat, model);
+			return true;
+		}
+		if (result == SAT_UNKNOWN)
+			return false;
+	}
+	return false;
+}
+
+bool FindModel(const ClauseSet& clauses, FiniteModel& model, const ModelOptions& opt) {
+	ModelFinder finder(clauses, opt);
+	return finder.Find(model);
+}
+
+}
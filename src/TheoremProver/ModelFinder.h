@@ -0,0 +1,48 @@
+#ifndef _TheoremProver_ModelFinder_h_
+#define _TheoremProver_ModelFinder_h_
+
+namespace TheoremProver {
+
+/*
+	Finite model finder (MACE/Paradox style).
+
+	The clauses are flattened so that every literal has only variables as
+	arguments and functions become relations with a result argument. For each
+	domain size the flat clauses are grounded into propositional clauses, together
+	with the totality and functionality of the function relations and symmetry
+	breaking on the constants, and given to the SAT solver.
+
+	A model of the axioms and the negated goal is a countermodel of the goal.
+*/
+
+struct ModelOptions {
+	int   max_size;            // largest domain size to try
+	int64 max_ground_clauses;  // give up when a domain size needs more ground clauses
+	int64 max_ground_vars;     // or more propositional variables
+	int64 conflict_limit;      // per domain size, -1 for no limit
+	int   deadline;            // msecs() after which no larger size is tried, 0 for no limit
+	const Atomic* cancel;      // the search gives up when it is set, NULL for none
+
+	ModelOptions() : max_size(6), max_ground_clauses(500000), max_ground_vars(500000), conflict_limit(20000), deadline(0), cancel(NULL) {}
+};
+
+class FiniteModel {
+
+public:
+	int size;
+	Vector<String> names;
+	Vector<int> arity;
+	Vector<bool> predicate;
+	Vector<Vector<int> > table;  // truth value or function value for each argument tuple
+
+	FiniteModel() : size(0) {}
+
+	String ToString() const;
+
+};
+
+bool FindModel(const ClauseSet& clauses, FiniteModel& model, const ModelOptions& opt = ModelOptions());
+
+}
+
+#endif
@@ -2,609 +2,337 @@
 
 namespace TheoremProver {
 
-
-bool IsAlphaNumber(int chr) {return IsAlpha ( chr ) || IsDigit ( chr );}
-bool IsAlphaNumber(const String& s) {
-	for(int i = 0; i < s.GetCount(); i++) {
-		if (!IsAlphaNumber(s[i]))
-			return false;
-	}
-	return s.GetCount();
-}
-bool IsLower(const String& s) {
-	for(int i = 0; i < s.GetCount(); i++) {
-		if (!Upp::IsLower(s[i]))
-			return false;
-	}
-	return s.GetCount();
-}
-bool HasUpper(const String& s) {
-	for(int i = 0; i < s.GetCount(); i++) {
-		if (Upp::IsUpper(s[i]))
-			return true;
+// Formula parser
+
+// Binary connectives from the loosest to the tightest. All of them are right
+// associative and bind looser than NOT. A quantifier takes everything up to
+// the end of its range as its formula.
+enum {
+	OP_NONE = -1,
+	OP_IMPLIES,
+	OP_EQUALS,
+	OP_OR,
+	OP_AND,
+	OP_NOT,
+};
+
+static const char* op_names[] = { "IMPLIES", "OR", "OR", "AND", "NOT" };
+
+static int GetBinaryOp ( const Token& token ) {
+	switch ( token.symbol ) {
+	case SYM_IMPLIES: return OP_IMPLIES;
+	case SYM_EQUALS:  return OP_EQUALS;
+	case SYM_OR:      return OP_OR;
+	case SYM_AND:     return OP_AND;
 	}
-	return false;
+	return OP_NONE;
 }
 
-Vector<String> Lex( const String& inp ) {
-	// perform a lexical analysis
-	Vector<String> tokens;
-	int pos = 0;
-
-	while ( pos < inp.GetCount() ) {
-		int chr = inp[pos];
-		
-		// skip whitespace
-		if ( chr == ' ' || chr == '\t' ) {
-			pos += 1;
-			continue;
-		}
-
-		// identifiers
-		String identifier;
-
-		while ( pos < inp.GetCount() ) {
-			chr = inp[pos];
-
-			if ( !IsAlphaNumber(chr) )
-				break;
-
-			identifier.Cat ( chr );
-			pos += 1;
+// Precedence climbing over one token array. Parenthetical groups, argument
+// lists and quantified formulae are parsed as ranges of the array, which end
+// at the matching parenthesis found beforehand, so every token is read once.
+class FormulaParser {
+	const TokenList& tokens;
+	Vector<int> match;               // position of the matching parenthesis or -1
+	int pos, end;                    // next token and the end of the current range
+	int operand, operand_item;       // start of the last operand and of its last argument
+	
+	NodeVar ParseRange ( int begin, int end );
+	NodeVar ParseBinary ( int min_op, int left_op );
+	NodeVar ParseUnary ( int left_op );
+	NodeVar ParseQuantifier ( bool forall );
+	int     ParseList ( int begin, int end, const char* missing, Vector<NodeVar>& out );
+	void    MissingFormula ( int left_op, int right_op );
+	void    Unparsed ();
+	
+	bool Is ( int i, int symbol ) const { return tokens[i].symbol == symbol; }
+	const String& GetName ( int i ) const { return tokens.GetName ( tokens[i].symbol ); }
+	
+public:
+	FormulaParser ( const TokenList& tokens, int begin );
+	
+	NodeVar Parse ( int begin ) { return ParseRange ( begin, tokens.GetCount() ); }
+};
+
+FormulaParser::FormulaParser ( const TokenList& tokens, int begin ) : tokens ( tokens ) {
+	pos = end = operand = operand_item = 0;
+	match.SetCount ( tokens.GetCount(), -1 );
+	Vector<int> open;
+	for ( int i = begin; i < tokens.GetCount(); i++ ) {
+		if ( Is ( i, SYM_LPAREN ) )
+			open.Add ( i );
+		else if ( Is ( i, SYM_RPAREN ) && open.GetCount() ) {
+			int j = open.Pop();
+			match[j] = i;
+			match[i] = j;
 		}
+	}
+}
 
-		if ( identifier.GetCount() ) {
-			tokens.Add ( identifier );
-			continue;
-		}
+NodeVar FormulaParser::ParseRange ( int begin, int end ) {
+	int prev_end = this->end;
+	pos = begin;
+	this->end = end;
+	
+	NodeVar formula = ParseBinary ( OP_IMPLIES, OP_NONE );
+	if ( pos < end )
+		Unparsed();
+	
+	this->end = prev_end;
+	return formula;
+}
 
-		// symbols
-		identifier.Clear();
-		identifier.Cat ( inp[pos] );
-		tokens.Add ( identifier );
+NodeVar FormulaParser::ParseBinary ( int min_op, int left_op ) {
+	NodeVar a = ParseUnary ( left_op );
+	
+	while ( pos < end ) {
+		int op = GetBinaryOp ( tokens[pos] );
+		if ( op == OP_NONE || op < min_op )
+			break;
 		pos += 1;
+		
+		NodeVar b = ParseBinary ( op, op );
+		if ( op == OP_IMPLIES )
+			a = new Implies ( *a, *b );
+		else if ( op == OP_EQUALS ) {
+			NodeVar impl_lr = new Implies ( *a, *b );
+			NodeVar impl_rl = new Implies ( *b, *a );
+			a = new And ( *impl_lr, *impl_rl );
+		}
+		else if ( op == OP_OR )
+			a = new Or ( *a, *b );
+		else
+			a = new And ( *a, *b );
 	}
-
-	// return the tokens
-	return tokens;
+	
+	return a;
 }
 
-NodeVar Parse( Vector<String>& tokens ) {
+NodeVar FormulaParser::ParseUnary ( int left_op ) {
+	if ( pos >= end )
+		MissingFormula ( left_op, OP_NONE );
 	
-	// keywords
-	Index<String> keywords;
-	keywords.Add ( "not" );
-	keywords.Add ( "implies" );
-	keywords.Add ( "and" );
-	keywords.Add ( "or" );
-	keywords.Add ( "forall" );
-	keywords.Add ( "exists" );
-
-	for ( int i = 0; i < tokens.GetCount(); i++ ) {
-		String s = ToLower ( tokens[i] );
-
-		if ( keywords.Find ( s ) != -1 )
-			tokens[i] = s;
+	const Token& token = tokens[pos];
+	int op = GetBinaryOp ( token );
+	if ( op != OP_NONE )
+		MissingFormula ( left_op, op );
+	
+	// Not
+	if ( token.symbol == SYM_NOT ) {
+		pos += 1;
+		return new Not ( *ParseUnary ( OP_NOT ) );
 	}
-
-	// empty formula
-	if ( tokens.GetCount() == 0 )
-		throw InvalidInputError ( "Empty formula." );
-
-	// ForAll
-	if ( tokens[0] == "forall" ) {
-		int dot_pos = -1;
-
-		for ( int i = 0; i < tokens.GetCount(); i++ ) {
-			if ( tokens[i] == "." ) {
-				dot_pos = i;
-				break;
-			}
-		}
-
-		if ( dot_pos == -1 ) {
-			throw InvalidInputError ( "Missing \".\" in FORALL quantifier." );
-		}
-
-		Vector<NodeVar> args;
-		int i = 1;
-
-		while ( i <= dot_pos ) {
-			int end = dot_pos;
-			int depth = 0;
-
-			for ( int j = i; j < dot_pos; j++ ) {
-				if ( tokens[j] == "(" ) {
-					depth += 1;
-					continue;
-				}
-
-				if ( tokens[j] == ")" ) {
-					depth -= 1;
-					continue;
-				}
-
-				if ( depth == 0 && tokens[j] == "," ) {
-					end = j;
-					break;
-				}
-			}
-
-			if ( i == end )
-				throw InvalidInputError ( "Missing variable in FORALL quantifier." );
-			
-			Vector<String> tmp;
-			for(int j = i; j < end; j++)
-				tmp.Add(tokens[j]);
-			
-			args.Add ( Parse( tmp ) );
-			i = end + 1;
-		}
-
-		if ( tokens.GetCount() == dot_pos + 1 ) {
-			throw InvalidInputError ( "Missing formula in FORALL quantifier." );
-		}
-		
-		Vector<String> tmp;
-		for(int j = dot_pos + 1; j < tokens.GetCount(); j++)
-			tmp.Add(tokens[j]);
-		
-		NodeVar formula = Parse( tmp );
-
-		for (int j = args.GetCount() - 1; j >= 0; j--)
-			formula = NodeVar(new ForAll ( *args[j], *formula ));
-		
+	
+	// ForAll, ThereExists
+	if ( token.symbol == SYM_FORALL || token.symbol == SYM_EXISTS )
+		return ParseQuantifier ( token.symbol == SYM_FORALL );
+	
+	int begin = pos;
+	operand = begin;
+	
+	// Group
+	if ( token.symbol == SYM_LPAREN ) {
+		int close = match[pos];
+		if ( close < 0 || close >= end )
+			throw InvalidInputError ( "Missing \")\"." );
+		if ( close == pos + 1 )
+			throw InvalidInputError ( "Missing formula in parenthetical group." );
+		NodeVar formula = ParseRange ( pos + 1, close );
+		pos = close + 1;
+		operand = begin;
 		return formula;
 	}
-
-	// ThereExists
-	if ( tokens[0] == "exists" ) {
-		int dot_pos = -1;
-
-		for ( int i = 1; i < tokens.GetCount(); i++) {
-			if ( tokens[i] == "." ) {
-				dot_pos = i;
-				break;
-			}
-		}
-
-		if ( dot_pos == -1 ) {
-			throw InvalidInputError ( "Missing \".\" in exists quantifier." );
-		}
-
-		if ( dot_pos == 1 ) {
-			throw InvalidInputError ( "Missing variable in exists quantifier." );
-		}
-
-		Vector<NodeVar> args;
-		int i = 1;
-
-		while ( i <= dot_pos ) {
-			int end = dot_pos;
-			int depth = 0;
-
-			for (int j = i; j < dot_pos; j++) {
-				if ( tokens[j] == "(" ) {
-					depth += 1;
-					continue;
-				}
-
-				if ( tokens[j] == ")" ) {
-					depth -= 1;
-					continue;
-				}
-
-				if ( depth == 0 && tokens[j] == "," ) {
-					end = j;
-					break;
-				}
-			}
-
-			if ( i == end )
-				throw InvalidInputError ( "Missing variable in exists quantifier." );
-			
-			Vector<String> tmp;
-			for(int j = i; j < end; j++)
-				tmp.Add(tokens[j]);
-			args.Add(Parse(tmp));
-			
-			i = end + 1;
-		}
-
-		if ( tokens.GetCount() == dot_pos + 1 )
-			throw InvalidInputError ( "Missing formula in exists quantifier." );
+	
+	if ( token.kind == TOKEN_PUNCT || token.kind == TOKEN_SYMBOL )
+		Unparsed();
+	
+	// Function, Predicate
+	bool call = pos + 1 < end && Is ( pos + 1, SYM_LPAREN );
+	if ( call && ( token.kind == TOKEN_LOWER || token.kind == TOKEN_UPPER ) ) {
+		bool is_fn = token.kind == TOKEN_LOWER;
+		int close = match[pos + 1];
+		if ( close < 0 || close >= end )
+			throw InvalidInputError ( is_fn ?
+				"Missing \")\" after function argument list." :
+				"Missing \")\" after predicate argument list." );
 		
-		Vector<String> tmp;
-		for(int j = dot_pos + 1; j < tokens.GetCount(); j++)
-			tmp.Add(tokens[j]);
-		NodeVar formula = Parse(tmp);
+		const String& name = GetName ( begin );
+		Vector<NodeVar> list;
+		int item = pos + 2;
+		if ( item < close )
+			item = ParseList ( item, close, is_fn ? "Missing function argument." : "Missing predicate argument.", list );
+		pos = close + 1;
+		operand = begin;
+		operand_item = item;
 		
-		for(int j = args.GetCount()-1; j >= 0; j--)
-			formula = new ThereExists ( *args[j], *formula );
-
-		return formula;
+		Index<NodeVar> args;
+		for ( int i = 0; i < list.GetCount(); i++ )
+			args.Add ( list[i] );
+		if ( is_fn )
+			return new Function ( name, args );
+		return new Predicate ( name, args );
 	}
-
-	// Implies
-	int implies_pos = -1;
-	int depth = 0;
-
-	for (int i = 0; i < tokens.GetCount(); i++) {
-		if ( tokens[i] == "(" ) {
-			depth += 1;
-			continue;
-		}
-
-		if ( tokens[i] == ")" ) {
-			depth -= 1;
-			if (depth < 0) break;
-			continue;
-		}
-
-		if ( depth == 0 && tokens[i] == "implies" ) {
-			implies_pos = i;
-			break;
-		}
+	
+	// Predicate
+	if ( !call && token.kind == TOKEN_UPPER ) {
+		pos += 1;
+		return new Predicate ( GetName ( begin ), Index<NodeVar>() );
 	}
-
-	if ( implies_pos != -1 ) {
-		bool quantifier_in_left = false;
-		int depth = 0;
-
-		for (int i = 0; i < implies_pos; i++) {
-			if ( tokens[i] == "(" ) {
-				depth += 1;
-				continue;
-			}
-
-			if ( tokens[i] == ")" ) {
-				depth -= 1;
-				if (depth < 0) break;
-				continue;
-			}
-
-			if ( depth == 0 && ( tokens[i] == "forall" || tokens[i] == "exists" ) ) {
-				quantifier_in_left = true;
-				break;
-			}
-		}
-
-		if ( !quantifier_in_left ) {
-			if ( implies_pos == 0 || implies_pos == tokens.GetCount() - 1 )
-				throw InvalidInputError ( "Missing formula in IMPLIES connective." );
-			
-			Vector<String> tmp1, tmp2;
-			for(int i = 0; i < implies_pos; i++)
-				tmp1.Add(tokens[i]);
-			for(int i = implies_pos+1; i < tokens.GetCount(); i++)
-				tmp2.Add(tokens[i]);
-			return new Implies ( *Parse(tmp1), *Parse(tmp2) );
-		}
+	
+	// Variable
+	if ( !call && token.kind == TOKEN_LOWER ) {
+		pos += 1;
+		return new Variable ( GetName ( begin ) );
 	}
 	
-	// Equals
-	int eq_pos = -1;
-	depth = 0;
-
-	for (int i = 0; i < tokens.GetCount(); i++) {
-		if ( tokens[i] == "(" ) {
-			depth += 1;
-			continue;
-		}
-
-		if ( tokens[i] == ")" ) {
-			depth -= 1;
-			if (depth < 0) break;
-			continue;
-		}
+	Unparsed();
+	return NodeVar();
+}
 
-		if ( depth == 0 && tokens[i] == "equals" ) {
-			eq_pos = i;
+NodeVar FormulaParser::ParseQuantifier ( bool forall ) {
+	int begin = pos;
+	int dot_pos = -1;
+	
+	for ( int i = begin + 1; i < end; i++ ) {
+		if ( Is ( i, SYM_DOT ) ) {
+			dot_pos = i;
 			break;
 		}
 	}
+	
+	if ( dot_pos == -1 )
+		throw InvalidInputError ( forall ?
+			"Missing \".\" in FORALL quantifier." :
+			"Missing \".\" in exists quantifier." );
+	
+	const char* missing_variable = forall ?
+		"Missing variable in FORALL quantifier." :
+		"Missing variable in exists quantifier.";
+	if ( dot_pos == begin + 1 )
+		throw InvalidInputError ( missing_variable );
+	
+	Vector<NodeVar> args;
+	ParseList ( begin + 1, dot_pos, missing_variable, args );
+	
+	if ( dot_pos == end - 1 )
+		throw InvalidInputError ( forall ?
+			"Missing formula in FORALL quantifier." :
+			"Missing formula in exists quantifier." );
+	
+	NodeVar formula = ParseRange ( dot_pos + 1, end );
+	pos = end;
+	
+	for ( int j = args.GetCount() - 1; j >= 0; j-- ) {
+		if ( forall )
+			formula = new ForAll ( *args[j], *formula );
+		else
+			formula = new ThereExists ( *args[j], *formula );
+	}
+	
+	return formula;
+}
 
-	if ( eq_pos != -1 ) {
-		bool quantifier_in_left = false;
-		int depth = 0;
+// parses the comma separated formulae of a non-empty range, returns the
+// start of the last one. A comma inside a parenthetical group belongs to the
+// group, so an argument may itself have several arguments, as in
+// "P(f(x, y)) implies P(f(x, y))". This is a deliberate change of the
+// grammar: the old parser split the list at every comma and rejected such
+// formulae.
+int FormulaParser::ParseList ( int begin, int end, const char* missing, Vector<NodeVar>& out ) {
+	int i = begin;
+	int last = begin;
+	
+	while ( i <= end ) {
+		int item_end = end;
 		
-		for (int i = 0; i < eq_pos; i++) {
-			if ( tokens[i] == "(" ) {
-				depth += 1;
-				continue;
-			}
-
-			if ( tokens[i] == ")" ) {
-				depth -= 1;
-				if (depth < 0) break;
+		for ( int j = i; j < end; j++ ) {
+			if ( Is ( j, SYM_LPAREN ) ) {
+				if ( match[j] < 0 || match[j] >= end )
+					break;
+				j = match[j];
 				continue;
 			}
-
-			if ( depth == 0 && ( tokens[i] == "forall" || tokens[i] == "exists" ) ) {
-				quantifier_in_left = true;
-				break;
-			}
-		}
-
-		if ( !quantifier_in_left ) {
-			if ( eq_pos == 0 || eq_pos == tokens.GetCount() - 1 )
-				throw InvalidInputError ( "Missing formula in OR connective." );
 			
-			Vector<String> tmp1, tmp2;
-			for(int i = 0; i < eq_pos; i++)
-				tmp1.Add(tokens[i]);
-			for(int i = eq_pos+1; i < tokens.GetCount(); i++)
-				tmp2.Add(tokens[i]);
+			if ( Is ( j, SYM_RPAREN ) )
+				break;
 			
-			NodeVar a = Parse(tmp1);
-			NodeVar b = Parse(tmp2);
-			NodeVar impl_lr = new Implies(*a, *b);
-			NodeVar impl_rl = new Implies(*b, *a);
-			return new And( *impl_lr, *impl_rl );
-		}
-	}
-
-	// Or
-	int or_pos = -1;
-	depth = 0;
-
-	for (int i = 0; i < tokens.GetCount(); i++) {
-		if ( tokens[i] == "(" ) {
-			depth += 1;
-			continue;
-		}
-
-		if ( tokens[i] == ")" ) {
-			depth -= 1;
-			if (depth < 0) break;
-			continue;
-		}
-
-		if ( depth == 0 && tokens[i] == "or" ) {
-			or_pos = i;
-			break;
-		}
-	}
-
-	if ( or_pos != -1 ) {
-		bool quantifier_in_left = false;
-		int depth = 0;
-		
-		for (int i = 0; i < or_pos; i++) {
-			if ( tokens[i] == "(" ) {
-				depth += 1;
-				continue;
-			}
-
-			if ( tokens[i] == ")" ) {
-				depth -= 1;
-				if (depth < 0) break;
-				continue;
-			}
-
-			if ( depth == 0 && ( tokens[i] == "forall" || tokens[i] == "exists" ) ) {
-				quantifier_in_left = true;
+			if ( Is ( j, SYM_COMMA ) ) {
+				item_end = j;
 				break;
 			}
 		}
-
-		if ( !quantifier_in_left ) {
-			if ( or_pos == 0 || or_pos == tokens.GetCount() - 1 )
-				throw InvalidInputError ( "Missing formula in OR connective." );
-			
-			Vector<String> tmp1, tmp2;
-			for(int i = 0; i < or_pos; i++)
-				tmp1.Add(tokens[i]);
-			for(int i = or_pos+1; i < tokens.GetCount(); i++)
-				tmp2.Add(tokens[i]);
-			return new Or ( *Parse(tmp1), *Parse(tmp2) );
-		}
+		
+		if ( i == item_end )
+			throw InvalidInputError ( missing );
+		
+		out.Add ( ParseRange ( i, item_end ) );
+		last = i;
+		i = item_end + 1;
 	}
-
-	// And
-	int and_pos = -1;
-	depth = 0;
 	
-	for (int i = 0; i < tokens.GetCount(); i++) {
-		if ( tokens[i] == "(" ) {
-			depth += 1;
-			continue;
-		}
+	return last;
+}
 
-		if ( tokens[i] == ")" ) {
-			depth -= 1;
-			if (depth < 0) break;
-			continue;
-		}
+// A missing operand is reported for the tighter of the connectives around
+// it, which is the one whose range it ends.
+void FormulaParser::MissingFormula ( int left_op, int right_op ) {
+	int op = max ( left_op, right_op );
+	if ( op == OP_NONE )
+		throw InvalidInputError ( "Empty formula." );
+	throw InvalidInputError ( Format ( "Missing formula in %s connective.", op_names[op] ) );
+}
 
-		if ( depth == 0 && tokens[i] == "and" ) {
-			and_pos = i;
+// Tokens are left at 'pos' after the operand which starts at 'operand'. The
+// operand is taken to end before the next connective, or at the end of the
+// range if a quantifier comes first, and a group or an argument list is
+// missing its ")" unless that is the last token.
+void FormulaParser::Unparsed () {
+	int op_end = pos;
+	while ( op_end < end && GetBinaryOp ( tokens[op_end] ) == OP_NONE ) {
+		if ( Is ( op_end, SYM_FORALL ) || Is ( op_end, SYM_EXISTS ) ) {
+			op_end = end;
 			break;
 		}
+		if ( Is ( op_end, SYM_LPAREN ) && match[op_end] > op_end && match[op_end] < end )
+			op_end = match[op_end];
+		op_end += 1;
 	}
-
-	if ( and_pos != -1 ) {
-		bool quantifier_in_left = false;
-		int depth = 0;
-		
-		for (int i = 0; i < and_pos; i++) {
-			if ( tokens[i] == "(" ) {
-				depth += 1;
-				continue;
-			}
-
-			if ( tokens[i] == ")" ) {
-				depth -= 1;
-				if (depth < 0) break;
-				continue;
-			}
-
-			if ( depth == 0 && ( tokens[i] == "forall" || tokens[i] == "exists" ) ) {
-				quantifier_in_left = true;
-				break;
-			}
-		}
-
-		if ( !quantifier_in_left ) {
-			if ( and_pos == 0 || and_pos == tokens.GetCount() - 1 )
-				throw InvalidInputError ( "Missing formula in AND connective." );
-			
-			Vector<String> tmp1, tmp2;
-			for(int i = 0; i < and_pos; i++)
-				tmp1.Add(tokens[i]);
-			for(int i = and_pos+1; i < tokens.GetCount(); i++)
-				tmp2.Add(tokens[i]);
-			return new And( *Parse(tmp1), *Parse(tmp2) );
-		}
-	}
-
-	// Not
-	if ( tokens[0] == "not" ) {
-		if ( tokens.GetCount() < 2 )
-			throw InvalidInputError ( "Missing formula in NOT connective." );
-		
-		Vector<String> tmp;
-		for(int i = 1; i < tokens.GetCount(); i++)
-			tmp.Add(tokens[i]);
-		return new Not ( *Parse(tmp) );
+	bool closed = Is ( op_end - 1, SYM_RPAREN );
+	
+	if ( Is ( operand, SYM_LPAREN ) ) {
+		if ( !closed )
+			throw InvalidInputError ( "Missing \")\"." );
+		throw InvalidInputError ( Format ( "Unable to parse: %s...", GetName ( pos ) ) );
 	}
-
-	// Function
-	if ( IsAlphaNumber(tokens[0]) && keywords.Find(ToLower(tokens[0])) == -1 &&
-		 tokens.GetCount() > 1 && IsLower(tokens[0]) && tokens[1] == "(" ) {
-		if ( tokens[tokens.GetCount() - 1] != ")" )
+	if ( operand + 1 < pos && Is ( operand + 1, SYM_LPAREN ) ) {
+		if ( closed )
+			throw InvalidInputError ( Format ( "Unable to parse: %s...", GetName ( operand_item ) ) );
+		if ( tokens[operand].kind == TOKEN_LOWER )
 			throw InvalidInputError ( "Missing \")\" after function argument list." );
-		
-		String name = tokens[0];
-
-		Index<NodeVar> args;
-		int i = 2;
-
-		if ( i < tokens.GetCount() - 1 ) {
-			while ( i <= tokens.GetCount() - 1 ) {
-				int end = tokens.GetCount() - 1;
-				int depth = 0;
-
-				for (int j = 0; j < tokens.GetCount() - 1; j++) {
-					if ( tokens[j] == "(" ) {
-						depth += 1;
-						continue;
-					}
-
-					if ( tokens[j] == ")" ) {
-						depth -= 1;
-						if (depth < 0) break;
-						continue;
-					}
-
-					if ( depth == 0 && tokens[j] == "," ) {
-						end = j;
-						break;
-					}
-				}
-
-				if ( i == end )
-					throw InvalidInputError ( "Missing function argument." );
-				
-				Vector<String> tmp;
-				for(int j = i; j < end; j++)
-					tmp.Add(tokens[j]);
-				args.Add(Parse(tmp));
-
-				i = end + 1;
-			}
-		}
-
-		return new Function ( name, args );
-	}
-
-	// Predicate
-	if ( IsAlphaNumber(tokens[0]) && keywords.Find(ToLower(tokens[0])) == -1 &&
-		 tokens.GetCount() == 1 && HasUpper(tokens[0]))
-		return new Predicate ( tokens[0], Index<NodeVar>() );
-
-	if ( IsAlphaNumber(tokens[0]) && keywords.Find(ToLower(tokens[0])) == -1 &&
-		 tokens.GetCount() > 1 && HasUpper(tokens[0]) && tokens[1] == "(" ) {
-		if ( tokens[tokens.GetCount() - 1] != ")" )
-			throw InvalidInputError ( "Missing \")\" after predicate argument list." );
-		
-		String name = tokens[0];
-
-		Index<NodeVar> args;
-		int i = 2;
-
-		if ( i < tokens.GetCount() - 1 ) {
-			while ( i <= tokens.GetCount() - 1 ) {
-				int end = tokens.GetCount() - 1;
-				int depth = 0;
-
-				for (int j = i; j < tokens.GetCount() - 1; j++) {
-					if ( tokens[j] == "(" ) {
-						depth += 1;
-						continue;
-					}
-
-					if ( tokens[j] == ")" ) {
-						depth -= 1;
-						if (depth < 0) break;
-						continue;
-					}
-
-					if ( depth == 0 && tokens[j] == "," ) {
-						end = j;
-						break;
-					}
-				}
-
-				if ( i == end )
-					throw InvalidInputError ( "Missing predicate argument." );
-				
-				Vector<String> tmp;
-				for(int j = i; j < end; j++)
-					tmp.Add(tokens[j]);
-				args.Add(Parse(tmp));
-
-				i = end + 1;
-			}
-		}
-
-		return new Predicate ( name, args );
-	}
-
-	// Variable
-	if ( IsAlphaNumber(tokens[0]) && keywords.Find(ToLower(tokens[0])) == -1 &&
-		 tokens.GetCount() == 1 && IsLower(tokens[0]) ) {
-		return new Variable ( tokens[0] );
+		throw InvalidInputError ( "Missing \")\" after predicate argument list." );
 	}
+	throw InvalidInputError ( Format ( "Unable to parse: %s...", GetName ( operand ) ) );
+}
 
-	// Group
-	if ( tokens[0] == "(" ) {
-		if ( tokens[tokens.GetCount() - 1] != ")" )
-			throw InvalidInputError ( "Missing \")\"." );
-		if ( tokens.GetCount() == 2 )
-			throw InvalidInputError ( "Missing formula in parenthetical group." );
-		Vector<String> tmp;
-		int depth = 0;
-		for(int i = 1; i < tokens.GetCount()-1; i++) {
-			String& t = tokens[i];
-			if (t == "(") depth++;
-			else if (t == ")") {if (!depth) break; depth--;}
-			tmp.Add(t);
-		}
-		return Parse(tmp);
-	}
+NodeVar Parse( const TokenList& tokens, int begin ) {
+	// empty formula
+	if ( begin >= tokens.GetCount() )
+		throw InvalidInputError ( "Empty formula." );
 	
-	throw InvalidInputError (Format("Unable to parse: %s...", tokens[0]));
+	FormulaParser parser ( tokens, begin );
+	return parser.Parse ( begin );
 }
 
 NodeVar UnsafeParse(String str) {
-	Vector<String> tokens = Lex(str);
+	TokenList tokens;
+	tokens.Lex(str);
 	return Parse(tokens);
 }
 
 NodeVar Parse(String str) {
 	try {
-		Vector<String> tokens = Lex(str);
+		TokenList tokens;
+		tokens.Lex(str);
 		return Parse(tokens);
 	}
 	catch (InvalidInputError e) {
@@ -613,97 +341,4 @@ NodeVar Parse(String str) {
 	return NodeVar();
 }
 
-extern String* catch_print;
-extern Index<NodeVar> axioms;
-extern ArrayMap<NodeVar, Index<NodeVar> > lemmas;
-
-void ClearLogic() {
-	axioms.Clear();
-	lemmas.Clear();
-}
-
-String AddAxiom(String str) {
-	String out;
-	catch_print = &out;
-	
-	NodeVar n = Parse(str);
-	if (n.Is()) {
-		try {
-			CheckFormula ( *n );
-			axioms.Insert (0, n );
-			return 0;
-		}
-		catch (...) {}
-	}
-	catch_print = 0;
-	return out;
-}
-
-String GetAxioms() {
-	String out;
-	catch_print = &out;
-	
-	for(int i = 0; i < axioms.GetCount(); i++) {
-		const NodeVar& axiom = axioms[i];
-		Print(axiom->ToString());
-	}
-	
-	catch_print = 0;
-	return out;
-}
-
-extern String* catch_print;
-extern Index<NodeVar> axioms;
-extern ArrayMap<NodeVar, Index<NodeVar> > lemmas;
-
-String ProveLemmaNode(NodeVar formula) {
-	String out;
-	catch_print = &out;
-	
-	Index<NodeVar> tmp2;
-	for(int i = 0; i < axioms.GetCount(); i++)
-		tmp2.Add(axioms[i]);
-	for(int i = 0; i < lemmas.GetCount(); i++)
-		if (tmp2.Find(lemmas.GetKey(i)) == -1)
-			tmp2.Add(lemmas.GetKey(i));
-	
-	bool result = ProveFormula ( tmp2, formula );
-
-	if ( result ) {
-		lemmas.GetAdd(formula) <<= axioms;
-		Print ( Format( "Lemma proven: %s.", formula->ToString() ));
-	}
-	else
-		Print ( Format( "Lemma unprovable: %s.", formula->ToString() ));
-	
-	catch_print = 0;
-	return out;
-}
-
-String ProveLemma(String str) {
-	NodeVar n = Parse(str);
-	if (n.Is()) {
-		try {
-			CheckFormula ( *n );
-			return ProveLemmaNode(n);
-		}
-		catch (...) {}
-	}
-	return "";
-}
-
-String GetLemmas() {
-	String out;
-	catch_print = &out;
-	
-	for(int i = 0; i < lemmas.GetCount(); i++) {
-		const NodeVar& lemma = lemmas.GetKey(i);
-		Print(lemma->ToString());
-	}
-	
-	catch_print = 0;
-	return out;
-}
-
-
 }
@@ -0,0 +1,191 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+int Proof::AddNode(const NodeVar& n) {
+	int i = nodes.Find(n);
+	if (i != -1)
+		return i;
+	nodes.Add(n);
+	return nodes.GetCount() - 1;
+}
+
+int Proof::AddSequent(const NodeVar& sequent, const ArrayMap<NodeVar, int>& left, const ArrayMap<NodeVar, int>& right) {
+	int id = AddNode(sequent);
+	if (sequents.Find(id) != -1)
+		return id;
+
+	ProofSequent& s = sequents.Add(id);
+	s.first = sequent_formulas.GetCount();
+	s.left = left.GetCount();
+	s.right = right.GetCount();
+	for(int i = 0; i < left.GetCount(); i++)
+		sequent_formulas.Add(AddNode(left.GetKey(i)));
+	for(int i = 0; i < right.GetCount(); i++)
+		sequent_formulas.Add(AddNode(right.GetKey(i)));
+	return id;
+}
+
+int Proof::AddStep(int sequent, int parent, int depth) {
+	ProofStep& s = steps.Add();
+	s.kind = STEP_OPEN;
+	s.parent = parent;
+	s.depth = depth;
+	s.sequent = sequent;
+	s.formula = -1;
+	s.side = SIDE_NONE;
+	s.reason = -1;
+	s.first = bindings.GetCount();
+	s.count = 0;
+	s.first_child = children.GetCount();
+	s.child_count = 0;
+	s.first_closed = closed.GetCount();
+	s.closed_count = 0;
+	return steps.GetCount() - 1;
+}
+
+void Proof::SetRule(int step, int side, const NodeVar& formula) {
+	ProofStep& s = steps[step];
+	s.kind = STEP_EXPAND;
+	s.side = side;
+	s.formula = AddNode(formula);
+}
+
+void Proof::GiveUp(int step, int reason) {
+	ProofStep& s = steps[step];
+	s.kind = STEP_GIVE_UP;
+	s.reason = reason;
+}
+
+void Proof::AddBinding(int step, const NodeVar& term, const NodeVar& value) {
+	ProofStep& s = steps[step];
+	s.kind = STEP_UNIFY;
+	bindings.Add(AddNode(term));
+	bindings.Add(AddNode(value));
+	s.count++;
+}
+
+void Proof::AddChild(int step, int sequent) {
+	children.Add(sequent);
+	steps[step].child_count++;
+}
+
+void Proof::AddClosed(int step, int sequent, int parent) {
+	closed.Add(sequent);
+	closed.Add(parent);
+	steps[step].closed_count++;
+}
+
+int Proof::GetStepCount(int kind) const {
+	int count = 0;
+	for(int i = 0; i < steps.GetCount(); i++)
+		if (steps[i].kind == kind)
+			count++;
+	return count;
+}
+
+String Proof::GetStatus() const {
+	if (proven)
+		return "proven";
+	if (model.size)
+		return "countermodel";
+	if (connection.exhausted)
+		return "unprovable";
+	if (timeout)
+		return "timeout";
+	return "unknown";
+}
+
+String Proof::GetVerdict() const {
+	String status = GetStatus();
+	if (status == "proven" || status == "unprovable")
+		return status;
+	if (status == "countermodel")
+		return "unprovable";
+	return "not proven (" + status + ")";
+}
+
+static const char* GetGiveUpText(int reason) {
+	switch (reason) {
+	case GIVE_UP_REPEATED: return "Unable to continue: the sequent repeats";
+	case GIVE_UP_DEPTH:    return "Unable to continue: depth limit reached";
+	case GIVE_UP_TIMEOUT:  return "Time limit reached";
+	case GIVE_UP_CANCEL:   return "Search canceled";
+	}
+	return "Unable to continue";
+}
+
+String Proof::ToString() const {
+	String out;
+
+	if (model.size) {
+		out << model.ToString() << "\n";
+		return out;
+	}
+
+	if (engine == ENGINE_CONNECTION) {
+		if (connection.proven)
+			out << Format("Connection proof found with path limit %d (%d inferences).\n", connection.path_limit, connection.inferences);
+		else if (connection.timeout)
+			out << Format("Time limit reached at path limit %d.\n", connection.path_limit);
+		else if (!connection.exhausted)
+			out << Format("Path limit %d reached.\n", connection.path_limit);
+		return out;
+	}
+
+	for(int i = 0; i < steps.GetCount(); i++) {
+		const ProofStep& s = steps[i];
+		out << Format("%d. %s\n", s.depth, nodes[s.sequent]->ToString());
+
+		for(int j = 0; j < s.count; j++) {
+			const NodeVar& term = nodes[bindings[s.first + 2 * j]];
+			const NodeVar& value = nodes[bindings[s.first + 2 * j + 1]];
+			out << Format("  %s = %s\n", term->ToString(), value->ToString());
+		}
+
+		if (s.kind == STEP_GIVE_UP)
+			out << GetGiveUpText(s.reason) << "\n";
+	}
+	return out;
+}
+
+void Proof::Clear() {
+	nodes.Clear();
+	steps.Clear();
+	bindings.Clear();
+	children.Clear();
+	closed.Clear();
+	sequents.Clear();
+	sequent_formulas.Clear();
+	axioms.Clear();
+	goal.Clear();
+	engine = ENGINE_SEQUENT;
+	proven = false;
+	timeout = false;
+	deadline = 0;
+	cancel = NULL;
+	unifications = 0;
+	clauses.Clear();
+	connection = ConnectionResult();
+	model = FiniteModel();
+	region.Clear();
+	if (GetCycleRootCount())
+		CollectCycles();
+}
+
+static bool HasRegionNode(Node& n, const RefContext& region) {
+	if (n.IsInContext(&region))
+		return true;
+	for(int i = 0; i < n.GetCount(); i++)
+		if (HasRegionNode(n[i], region))
+			return true;
+	return false;
+}
+
+NodeVar Proof::Promote(const NodeVar& n) const {
+	if (!n.Is() || !HasRegionNode(*n, region))
+		return n;
+	return CopyNode(*n);
+}
+
+}
@@ -0,0 +1,122 @@
+#ifndef _TheoremProver_Proof_h_
+#define _TheoremProver_Proof_h_
+
+namespace TheoremProver {
+
+/*
+	Record of a proof search.
+
+	The sequent search adds one step per dequeued sequent. Steps refer to the
+	sequents and principal formulas by node id, which is the position in 'nodes'.
+	Equal nodes share an id, so the record is a DAG of rule applications and
+	nothing is formatted until ToString is called.
+
+	GetCertificate writes the record in the plain text format read by the
+	ProofChecker package, which checks it without using the prover's code.
+	A connection proof is written as the clauses and the closed tableau of
+	ConnectionResult, so 'clauses' is kept with the record.
+
+	The nodes created by the search are allocated in the region of the
+	proof. Their handles don't count references to them: the region keeps
+	them for the record, and when the proof is cleared or destroyed it runs
+	their destructors and frees their memory in one step. A node of the
+	region which must outlive the proof is copied out with Promote.
+*/
+
+enum {
+	ENGINE_SEQUENT,
+	ENGINE_CONNECTION
+};
+
+enum {
+	STEP_OPEN,     // no rule could be applied
+	STEP_EXPAND,   // a rule was applied to the principal formula
+	STEP_AXIOM,    // closed, the same formula is on both sides
+	STEP_UNIFY,    // closed with its siblings by a unifier
+	STEP_GIVE_UP   // the search stopped here
+};
+
+// why the search stopped at a STEP_GIVE_UP
+enum {
+	GIVE_UP_REPEATED,  // the sequent is the same as the one before
+	GIVE_UP_DEPTH,     // the depth limit was reached
+	GIVE_UP_TIMEOUT,
+	GIVE_UP_CANCEL
+};
+
+enum {
+	SIDE_NONE,
+	SIDE_LEFT,
+	SIDE_RIGHT
+};
+
+struct ProofStep : Moveable<ProofStep> {
+	int kind;
+	int parent;        // step which produced the sequent, -1 for the goal
+	int depth;
+	int sequent;
+	int formula;
+	int side;
+	int reason;        // GIVE_UP_* of a STEP_GIVE_UP
+	int first, count;  // unifier pairs in Proof::bindings
+	int first_child, child_count;    // sequents in Proof::children
+	int first_closed, closed_count;  // sequent and parent step pairs in Proof::closed
+};
+
+// formula node ids of a sequent in Proof::sequent_formulas
+struct ProofSequent : Moveable<ProofSequent> {
+	int first, left, right;
+};
+
+class Proof {
+
+public:
+	// destroyed last, after every node of the members below
+	RefContext region;
+	
+	Index<NodeVar> nodes;
+	Vector<ProofStep> steps;
+	Vector<int> bindings;
+	Vector<int> children;
+	Vector<int> closed;
+	VectorMap<int, ProofSequent> sequents;
+	Vector<int> sequent_formulas;
+
+	Vector<NodeVar> axioms;
+	NodeVar goal;
+
+	int engine;
+	bool proven;
+	bool timeout;
+	int deadline;       // msecs() at which the search gives up, 0 for no limit
+	const Atomic* cancel; // the search gives up when it is set, NULL for none
+	int unifications;   // attempted unifiers of the sequent search
+	ClauseSet clauses;  // of the connection engine and the model finder
+	ConnectionResult connection;
+	FiniteModel model;
+
+	Proof() : engine(ENGINE_SEQUENT), proven(false), timeout(false), deadline(0), cancel(NULL), unifications(0) {region.SetRegion();}
+	~Proof() {Clear();}
+
+	int AddNode(const NodeVar& n);
+	int AddSequent(const NodeVar& sequent, const ArrayMap<NodeVar, int>& left, const ArrayMap<NodeVar, int>& right);
+	int AddStep(int sequent, int parent, int depth);
+	void SetRule(int step, int side, const NodeVar& formula);
+	void GiveUp(int step, int reason);
+	void AddBinding(int step, const NodeVar& term, const NodeVar& value);
+	void AddChild(int step, int sequent);
+	void AddClosed(int step, int sequent, int parent);
+
+	NodeVar Promote(const NodeVar& n) const;
+	int GetStepCount(int kind) const;
+	String GetStatus() const;  // proven, countermodel, unprovable, timeout or unknown
+	String GetVerdict() const; // the status as a sentence: unprovable only when it's settled
+	String ToString() const;
+	String GetCertificate() const;
+	void Clear();
+
+};
+
+}
+
+#endif
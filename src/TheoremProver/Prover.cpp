@@ -26,34 +26,33 @@ int& GetInsert(ArrayMap<NodeVar, int>& data, const NodeVar& ref) {
 
 // Unification
 
+// The unifiers are added to 'out'. A unifier counts only if it binds a term,
+// so the functions return false and leave 'out' as it was if the terms do not
+// unify or if they are equal without substitution.
+
 // solve a single equation
-ArrayMap<NodeVar, NodeVar> Unify(Node& term_a, Node& term_b) {
+bool Unify(Node& term_a, Node& term_b, VectorMap<NodeVar, NodeVar>& out) {
 	UnificationTerm* uniterm_a = dynamic_cast<UnificationTerm*>(&term_a);
 	UnificationTerm* uniterm_b = dynamic_cast<UnificationTerm*>(&term_b);
-	ArrayMap<NodeVar, NodeVar> out;
 	
 	if (uniterm_a) {
 		if (term_b.Occurs(*uniterm_a) || term_b.GetTime() > term_a.GetTime())
-			return out;
+			return false;
 		
 		out.Add(&term_a, &term_b);
-		return out;
+		return true;
 	}
 
 	if (uniterm_b) {
 		if (term_a.Occurs(*uniterm_b) || term_a.GetTime() > term_b.GetTime())
-			return out;
+			return false;
 
 		out.Add(&term_b, &term_a);
-		return out;
+		return true;
 	}
 
-	if (dynamic_cast<Variable*>(&term_a) && dynamic_cast<Variable*>(&term_b)) {
-		if (term_a == term_b)
-			return { };
-
-		return out;
-	}
+	if (dynamic_cast<Variable*>(&term_a) && dynamic_cast<Variable*>(&term_b))
+		return false;
 
 	Function* fn_a = dynamic_cast<Function*>(&term_a);
 	Function* fn_b = dynamic_cast<Function*>(&term_b);
@@ -62,124 +61,180 @@ ArrayMap<NodeVar, NodeVar> Unify(Node& term_a, Node& term_b) {
 	
 	if ((fn_a && fn_b) || (pred_a && pred_b)) {
 		if (term_a.GetName() != term_b.GetName())
-			return out;
+			return false;
 		
 		bool is_fn = (fn_a && fn_b);
 		Index<NodeVar>& a_terms = is_fn ? fn_a->terms : pred_a->terms;
 		Index<NodeVar>& b_terms = is_fn ? fn_b->terms : pred_b->terms;
 		
-		if (a_terms.GetCount() != b_terms.GetCount())
-			return out;
+		if (a_terms.GetCount() != b_terms.GetCount() || a_terms.GetCount() == 0)
+			return false;
 
-		ArrayMap<NodeVar, NodeVar> substitution;
+		// the substitution of the previous arguments is applied to each one
+		int begin = out.GetCount();
 
 		for (int i = 0; i < a_terms.GetCount(); i++) {
 			NodeVar a = a_terms[i];
 			NodeVar b = b_terms[i];
 			
-			for (int j = 0; j < substitution.GetCount(); j++) {
-				const NodeVar& k = substitution.GetKey(j);
-				NodeVar& v = substitution[j];
+			for (int j = begin; j < out.GetCount(); j++) {
+				const NodeVar& k = out.GetKey(j);
+				NodeVar& v = out[j];
 				a = a->Replace(*k, *v);
 				b = b->Replace(*k, *v);
 			}
 
-			ArrayMap<NodeVar, NodeVar> sub = Unify(*a, *b);
-
-			if (sub.GetCount() == 0)
-				return out;
-			
-			for(int j = 0; j < sub.GetCount(); j++) {
-				const NodeVar& k = sub.GetKey(j);
-				NodeVar& v = sub[j];
-				substitution.Add(k, v);
+			if (!Unify(*a, *b, out)) {
+				out.Trim(begin);
+				return false;
 			}
 		}
 
-		return substitution;
+		return true;
 	}
 
-	return out;
+	return false;
 }
 
 // solve a list of equations
-ArrayMap<NodeVar, NodeVar> UnifyList(const ArrayMap<NodeVar, NodeVar>& pairs) {
-	ArrayMap<NodeVar, NodeVar> substitution;
+bool UnifyList(const VectorMap<NodeVar, NodeVar>& pairs, VectorMap<NodeVar, NodeVar>& out) {
+	int begin = out.GetCount();
 	
 	for (int i = 0; i < pairs.GetCount(); i++) {
-		const NodeVar& term_a = pairs.GetKey(i);
-		const NodeVar& term_b = pairs[i];
-		NodeVar a = term_a;
-		NodeVar b = term_b;
+		NodeVar a = pairs.GetKey(i);
+		NodeVar b = pairs[i];
 		
-		for(int j = 0; j < substitution.GetCount(); j++) {
-			const NodeVar& k = substitution.GetKey(j);
-			NodeVar& v = substitution[j];
+		for(int j = begin; j < out.GetCount(); j++) {
+			const NodeVar& k = out.GetKey(j);
+			NodeVar& v = out[j];
 			a = a->Replace(*k, *v);
 			b = b->Replace(*k, *v);
 		}
 
-		ArrayMap<NodeVar, NodeVar> sub = Unify(*a, *b);
-
-		if (sub.GetCount() == 0)
-			return ArrayMap<NodeVar, NodeVar>();
-		
-		for(int j = 0; j < sub.GetCount(); j++) {
-			const NodeVar& k = sub.GetKey(j);
-			NodeVar& v = sub[j];
-			substitution.Add(k, v);
+		if (!Unify(*a, *b, out)) {
+			out.Trim(begin);
+			return false;
 		}
 	}
 
-	return substitution;
+	return out.GetCount() > begin;
+}
+
+// Sibling lists
+
+// A sequent and the siblings which have to be closed by the same unifier.
+// The list of a new sequent is the list of its parent with the sequent in
+// front, and the cells of the parent are shared, so joining takes one cell
+// and the cells are never modified. Each sequent sees its own list, the
+// branches differ in their members, so the lists hold no state of their
+// own: a closed list is recorded by adding its sequents to the proven ones,
+// and the unifiable pairs are kept by each sequent.
+class SiblingList : public Ref<SiblingList> {
+	
+public:
+	NodeVar sequent;
+	Var<SiblingList> next;
+	int count;
+	
+	SiblingList(const NodeVar& sequent, const Var<SiblingList>& next)
+		: Ref<SiblingList>(TheoremProver::GetContext()), sequent(sequent) {
+		this->next << next;
+		count = next.Is() ? next->count + 1 : 1;
+	}
+	
+	virtual void GetReferences(Vector<RefBase*>& out) {
+		out.Add(sequent.GetNode());
+		out.Add(next.GetNode());
+	}
+	
+};
+
+typedef Var<SiblingList> SiblingListVar;
+
+static int GetCount(const SiblingListVar& list) {
+	return list.Is() ? list->count : 0;
+}
+
+static SiblingListVar Join(const SiblingListVar& list, const NodeVar& sequent) {
+	return new SiblingList(sequent, list);
+}
+
+// Removes the sequent from its own list. A sequent with siblings joins its
+// list when it's created and nothing is put in front of it before it's
+// dequeued, so it is the first cell, if it's in the list at all.
+static void Unlink(SiblingListVar& list, const NodeVar& sequent) {
+	if (list.Is() && list->sequent.GetNode() == sequent.GetNode())
+		list << SiblingListVar(list->next);
 }
 
 // Sequents
 class Sequent : public Node {
 	
 protected:
-	friend bool ProveSequent(Node& sequent);
+	friend bool ProveSequent(Node& sequent, Proof& proof);
 	
 	ArrayMap<NodeVar, int> left, right;
-	Index<NodeVar> siblings;
+	SiblingListVar siblings;
 	int depth;
+	int parent_step;
+	
+	// unifiable pairs, found when the sequent is first unified with its siblings
+	VectorMap<NodeVar, NodeVar> pairs;
+	bool has_pairs;
+	
+	// ground terms of the branch, the index of the parent until it is first used
+	GroundTermIndexVar ground;
+	bool has_ground;
 	
 public:
-	Sequent(const ArrayMap<NodeVar, int>& left, const ArrayMap<NodeVar, int>& right, const Index<NodeVar>& siblings, int depth) : Node("") {
+	Sequent(const ArrayMap<NodeVar, int>& left, const ArrayMap<NodeVar, int>& right, const SiblingListVar& siblings, int depth) : Node("") {
 		this->left <<= left;
 		this->right <<= right;
-		this->siblings <<= siblings;
+		this->siblings << siblings;
 		this->depth = depth;
+		this->parent_step = -1;
+		this->has_pairs = false;
+		this->has_ground = false;
+		
+		// a sequent is put among its own siblings, so a sequent which is not
+		// registered can only be deleted by the cycle collector
+		if (IsInContext(NULL))
+			AddCycleRoot(*this);
+	}
+	
+	virtual void GetReferences(Vector<RefBase*>& out) {
+		for(int i = 0; i < left.GetCount(); i++)
+			out.Add(left.GetKey(i).GetNode());
+		for(int i = 0; i < right.GetCount(); i++)
+			out.Add(right.GetKey(i).GetNode());
+		out.Add(siblings.GetNode());
+		out.Add(ground.GetNode());
+		for(int i = 0; i < pairs.GetCount(); i++) {
+			out.Add(pairs.GetKey(i).GetNode());
+			out.Add(pairs[i].GetNode());
+		}
 	}
 
-	virtual Index<NodeVar> FreeVariables() {
-		Index<NodeVar> result;
-
+	virtual void FreeVariables(Index<NodeVar>& out) {
 		for(int i = 0; i < left.GetCount(); i++)
-			Append(result, left.GetKey(i)->FreeVariables());
+			left.GetKey(i)->FreeVariables(out);
 		
 		for(int i = 0; i < right.GetCount(); i++)
-			Append(result, right.GetKey(i)->FreeVariables());
-		
-		return result;
+			right.GetKey(i)->FreeVariables(out);
 	}
 
-	virtual Index<NodeVar> FreeUnificationTerms() {
-		Index<NodeVar> result;
-
+	virtual void FreeUnificationTerms(Index<NodeVar>& out) {
 		for(int i = 0; i < left.GetCount(); i++)
-			Append(result, left.GetKey(i)->FreeUnificationTerms());
+			left.GetKey(i)->FreeUnificationTerms(out);
 		
 		for(int i = 0; i < right.GetCount(); i++)
-			Append(result, right.GetKey(i)->FreeUnificationTerms());
-		
-		return result;
+			right.GetKey(i)->FreeUnificationTerms(out);
 	}
 
 	String GetVariableName(const String& prefix) {
 		Index<NodeVar> fv;
-		Append(fv, FreeVariables());
-		Append(fv, FreeUnificationTerms());
+		FreeVariables(fv);
+		FreeUnificationTerms(fv);
 		int index = 1;
 		String name = prefix + IntStr(index);
 
@@ -196,48 +251,73 @@ public:
 		return name;
 	}
 
-	ArrayMap<NodeVar, NodeVar> GetUnifiablePairs() {
-		ArrayMap<NodeVar, NodeVar> pairs;
+	// a layer over the index of the parent, with the formulas it doesn't have
+	const GroundTermIndex& GetGroundTerms() {
+		if (has_ground)
+			return *ground;
+		has_ground = true;
+		
+		ground = new GroundTermIndex(ground);
+		for(int i = 0; i < left.GetCount(); i++)
+			ground->AddFormula(left.GetKey(i));
+		
+		for(int i = 0; i < right.GetCount(); i++)
+			ground->AddFormula(right.GetKey(i));
+		return *ground;
+	}
+
+	// the sequent is not modified after it is dequeued, so the pairs are kept
+	const VectorMap<NodeVar, NodeVar>& GetUnifiablePairs() {
+		if (has_pairs)
+			return pairs;
+		has_pairs = true;
 
+		VectorMap<NodeVar, NodeVar> tmp;
 		for (int i = 0; i < left.GetCount(); i++) {
 			const NodeVar& formula_left = left.GetKey(i);
 			for (int j = 0; j < right.GetCount(); j++) {
 				const NodeVar& formula_right = right.GetKey(j);
-				ArrayMap<NodeVar, NodeVar> tmp = Unify(*formula_left, *formula_right);
-				if (tmp.GetCount())
+				if (Unify(*formula_left, *formula_right, tmp)) {
 					pairs.Add(formula_left, formula_right);
+					tmp.Trim(0);
+				}
 			}
 		}
 
 		return pairs;
 	}
 
+	// formula by formula and in order, like GetHashValue; the formulas are
+	// compared structurally, as the keys of the maps match by hash only
 	virtual bool operator==(Node& other) {
 		Sequent* seq = dynamic_cast<Sequent*>(&other);
+		if (!seq || left.GetCount() != seq->left.GetCount() || right.GetCount() != seq->right.GetCount())
+			return false;
 		
 		for (int i = 0; i < left.GetCount(); i++) {
-			if (seq->left.Find(left.GetKey(i)) == -1)
-				return false;
-		}
-
-		for (int i = 0; i < seq->left.GetCount(); i++) {
-			if (left.Find(seq->left.GetKey(i)) == -1)
+			if (!(*left.GetKey(i) == *seq->left.GetKey(i)))
 				return false;
 		}
 
 		for (int i = 0; i < right.GetCount(); i++) {
-			if (seq->right.Find(right.GetKey(i)) == -1)
-				return false;
-		}
-
-		for (int i = 0; i < seq->right.GetCount(); i++) {
-			if (right.Find(seq->right.GetKey(i)) == -1)
+			if (!(*right.GetKey(i) == *seq->right.GetKey(i)))
 				return false;
 		}
 
 		return true;
 	}
 
+	// the sequent is modified after it's created, so the hash is not cached
+	virtual uint32 GetHashValue() const {
+		CombineHash h;
+		for(int i = 0; i < left.GetCount(); i++)
+			h.Put(left.GetKey(i).GetHashValue());
+		h.Put(0);
+		for(int i = 0; i < right.GetCount(); i++)
+			h.Put(right.GetKey(i).GetHashValue());
+		return h;
+	}
+
 	virtual String ToString() const {
 		String left_part, right_part;
 		
@@ -267,7 +347,7 @@ public:
 
 // returns true if the sequent == provable
 // returns false || loops forever if the sequent != provable
-bool ProveSequent(Node& sequent_) {
+bool ProveSequent(Node& sequent_, Proof& proof) {
 	Sequent& sequent = dynamic_cast<Sequent&>(sequent_);
 	
 	// reset the time for each formula in the sequent
@@ -285,7 +365,7 @@ bool ProveSequent(Node& sequent_) {
 	Index<NodeVar> proven;
 	proven.Add(&sequent);
 	
-	String prev_str;
+	NodeVar prev;
 	
 	while (true) {
 		// get the next sequent
@@ -301,52 +381,70 @@ bool ProveSequent(Node& sequent_) {
 		
 		Sequent* old_sequent = old_sequent_.Get<Sequent>();
 		ASSERT(old_sequent);
-		String seq_str = old_sequent->ToString();
-		if (seq_str == prev_str || old_sequent->depth > 10) {
-			Print("Unable to continue");
+		int seq_id = proof.AddSequent(old_sequent_, old_sequent->left, old_sequent->right);
+		int step = proof.AddStep(seq_id, old_sequent->parent_step, old_sequent->depth);
+		TRACESTEP(Format("%d. %s", old_sequent->depth, old_sequent->ToString()));
+		// the sequents are compared only when the hashes match, to rule out a collision
+		bool repeated = prev.Is() && prev.GetHashValue() == old_sequent_.GetHashValue() &&
+		                *prev == *old_sequent;
+		if (repeated || old_sequent->depth > 10) {
+			proof.GiveUp(step, repeated ? GIVE_UP_REPEATED : GIVE_UP_DEPTH);
+			TRACESTEP("Unable to continue");
+			return false;
+		}
+		if (proof.deadline && msecs(proof.deadline) >= 0) {
+			proof.GiveUp(step, GIVE_UP_TIMEOUT);
+			proof.timeout = true;
+			TRACESTEP("Time limit reached");
+			return false;
+		}
+		if (proof.cancel && *proof.cancel) {
+			proof.GiveUp(step, GIVE_UP_CANCEL);
+			TRACESTEP("Search canceled");
 			return false;
 		}
-		prev_str = seq_str;
-		Print(Format("%d. %s", old_sequent->depth, seq_str));
+		prev = old_sequent_;
 
 		// check if this sequent == axiomatically true without unification
 		if (GetIndexCommonCount(old_sequent->left, old_sequent->right) > 0) {
+			proof.steps[step].kind = STEP_AXIOM;
 			proven.Insert(0, old_sequent);
 			continue;
 		}
 
 		// check if this sequent has unification terms
-		if (old_sequent->siblings.GetCount()) {
+		if (GetCount(old_sequent->siblings)) {
 			
 			// get the unifiable pairs for each sibling
-			Vector<ArrayMap<NodeVar, NodeVar> > sibling_pair_lists;
-			for(int i = 0; i < old_sequent->siblings.GetCount(); i++) {
-				sibling_pair_lists.Add(old_sequent->siblings[i].Get<Sequent>()->GetUnifiablePairs());
+			Vector<const VectorMap<NodeVar, NodeVar>*> sibling_pair_lists;
+			for(SiblingList* g = old_sequent->siblings.GetNode(); g; g = g->next.GetNode()) {
+				sibling_pair_lists.Add(&g->sequent.Get<Sequent>()->GetUnifiablePairs());
 			}
 
 			// check if there == a unifiable pair for each sibling
 			bool all_has_count = true;
 			for(int i = 0; i < sibling_pair_lists.GetCount(); i++)
-				if (sibling_pair_lists[i].GetCount() == 0)
+				if (sibling_pair_lists[i]->GetCount() == 0)
 					all_has_count = false;
 			
 			if (all_has_count) {
 				
 				// iterate through all simultaneous choices of pairs from each sibling
-				ArrayMap<NodeVar, NodeVar> substitution;
+				VectorMap<NodeVar, NodeVar> substitution;
+				VectorMap<NodeVar, NodeVar> tmp;
 				Vector<int> index;
 				index.SetCount(sibling_pair_lists.GetCount(), 0);
 
 				while (true) {
 					// attempt to unify at the index
-					ArrayMap<NodeVar, NodeVar> tmp;
+					tmp.Trim(0);
 					for(int i = 0; i < sibling_pair_lists.GetCount(); i++) {
 						int j = index[i];
-						tmp.Add(sibling_pair_lists[i].GetKey(j), sibling_pair_lists[i][j]);
+						tmp.Add(sibling_pair_lists[i]->GetKey(j), (*sibling_pair_lists[i])[j]);
 					}
-					substitution = UnifyList(tmp);
+					proof.unifications++;
 
-					if (substitution.GetCount())
+					if (UnifyList(tmp, substitution))
 						break;
 
 					// increment the index
@@ -355,7 +453,7 @@ bool ProveSequent(Node& sequent_) {
 					while (pos >= 0) {
 						index[pos] += 1;
 
-						if (index[pos] < sibling_pair_lists[pos].GetCount())
+						if (index[pos] < sibling_pair_lists[pos]->GetCount())
 							break;
 
 						index[pos] = 0;
@@ -368,36 +466,28 @@ bool ProveSequent(Node& sequent_) {
 
 				if (substitution.GetCount()) {
 					for(int i = 0; i < substitution.GetCount(); i++) {
-						const NodeVar& k = substitution.GetKey(i);
-						const NodeVar& v = substitution[i];
-						Print(Format( "  %s = %s", k->ToString(), v->ToString()));
+						proof.AddBinding(step, substitution.GetKey(i), substitution[i]);
+						TRACEDEBUG(Format("  %s = %s", substitution.GetKey(i)->ToString(), substitution[i]->ToString()));
 					}
-					
-					Append(proven, old_sequent->siblings);
-					
-					for(int i = 0; i < frontier.GetCount(); i++) {
-						if (old_sequent->siblings.Find(frontier[i]) != -1) {
-							frontier.Remove(i);
-							i--;
-						}
+					// the closed siblings still in the frontier are skipped
+					// when they are dequeued, as they are proven
+					for(SiblingList* g = old_sequent->siblings.GetNode(); g; g = g->next.GetNode()) {
+						Sequent* sibling = g->sequent.Get<Sequent>();
+						int id = proof.AddSequent(g->sequent, sibling->left, sibling->right);
+						proof.AddClosed(step, id, sibling->parent_step);
+						proven.Add(g->sequent);
 					}
-					//frontier = [sequent for sequent in frontier if sequent !in old_sequent->siblings];
 					continue;
 				}
 			}
 			else {
 				// unlink this sequent
-				while (1) {
-					int i = old_sequent->siblings.Find(old_sequent);
-					if (i != -1)
-						old_sequent->siblings.Remove(i);
-					else
-						break;
-				}
-				//old_sequent->siblings.remove(old_sequent);
+				Unlink(old_sequent->siblings, old_sequent_);
 			}
 		}
 
+		int frontier_count = frontier.GetCount();
+		
 		while (true) {
 			// determine which formula to expand
 			NodeVar left_formula;
@@ -428,7 +518,6 @@ bool ProveSequent(Node& sequent_) {
 					if (!dynamic_cast<Predicate*>(&*formula)) {
 						right_formula = formula;
 						right_depth = depth;
-						LOG(formula->AsString());
 					}
 				}
 			}
@@ -451,6 +540,12 @@ bool ProveSequent(Node& sequent_) {
 
 			if (!left_formula.Is() && !right_formula.Is())
 				return false;
+			
+			if (apply_left)
+				proof.SetRule(step, SIDE_LEFT, left_formula);
+			else
+				proof.SetRule(step, SIDE_RIGHT, right_formula);
+			TRACEDEBUG(Format("  expand %s %s", apply_left ? "left" : "right", (apply_left ? left_formula : right_formula)->ToString()));
 
 			// apply a left rule
 			if (apply_left) {
@@ -466,8 +561,8 @@ bool ProveSequent(Node& sequent_) {
 					RemoveRef(new__sequent->left, left_formula);
 					GetInsert(new__sequent->right, not_->formula) = (old_sequent->left.Get(left_formula) + 1);
 
-					//if (new__sequent->siblings.GetCount())
-						new__sequent->siblings.Insert(0, new__sequent);
+					//if (GetCount(new__sequent->siblings))
+						new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -487,8 +582,8 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->left, and_->formula_a) = (old_sequent->left.Get(left_formula) + 1);
 					GetInsert(new__sequent->left, and_->formula_b) = (old_sequent->left.Get(left_formula) + 1);
 
-					//if (new__sequent->siblings.GetCount())
-						new__sequent->siblings.Insert(0, new__sequent);
+					//if (GetCount(new__sequent->siblings))
+						new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -516,13 +611,13 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent_a->left, or_->formula_a) = (old_sequent->left.Get(left_formula) + 1);
 					GetInsert(new__sequent_b->left, or_->formula_b) = (old_sequent->left.Get(left_formula) + 1);
 
-					if (new__sequent_a->siblings.GetCount())
-						new__sequent_a->siblings.Insert(0, new__sequent_a);
+					if (GetCount(new__sequent_a->siblings))
+						new__sequent_a->siblings = Join(new__sequent_a->siblings, new__sequent_a);
 
 					frontier.Add(new__sequent_a);
 
-					if (new__sequent_b->siblings.GetCount())
-						new__sequent_b->siblings.Insert(0, new__sequent_b);
+					if (GetCount(new__sequent_b->siblings))
+						new__sequent_b->siblings = Join(new__sequent_b->siblings, new__sequent_b);
 
 					frontier.Add(new__sequent_b);
 					new__sequent_a->Dec();
@@ -551,13 +646,13 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent_a->right, implies->formula_a) = (old_sequent->left.Get(left_formula) + 1);
 					GetInsert(new__sequent_b->left,  implies->formula_b) = ( old_sequent->left.Get(left_formula) + 1);
 
-					if (new__sequent_a->siblings.GetCount())
-						new__sequent_a->siblings.Insert(0, new__sequent_a);
+					if (GetCount(new__sequent_a->siblings))
+						new__sequent_a->siblings = Join(new__sequent_a->siblings, new__sequent_a);
 
 					frontier.Add(new__sequent_a);
 
-					if (new__sequent_b->siblings.GetCount())
-						new__sequent_b->siblings.Insert(0, new__sequent_b);
+					if (GetCount(new__sequent_b->siblings))
+						new__sequent_b->siblings = Join(new__sequent_b->siblings, new__sequent_b);
 
 					frontier.Add(new__sequent_b);
 					new__sequent_a->Dec();
@@ -574,16 +669,43 @@ bool ProveSequent(Node& sequent_) {
 									  old_sequent->depth + 1
 								  );
 					new__sequent->Inc();
-					new__sequent->left.Get(left_formula) += 1;
-					NodeVar unterm = new UnificationTerm(old_sequent->GetVariableName("t"));
-					NodeVar formula = forall->formula->Replace(*forall->variable, *unterm);
-					formula->SetInstantiationTime(old_sequent->depth + 1);
-					SortByKey(new__sequent->left, NodeVar());
+					int applied = new__sequent->left.Get(left_formula) += 1;
+					
+					// instantiate with the ground terms matched by the triggers of the body
+					Index<NodeVar> instances;
+					EMatch(*forall->variable, *forall->formula, old_sequent->GetGroundTerms(), instances);
+					
+					int added = 0;
+					for(int i = 0; i < instances.GetCount(); i++) {
+						NodeVar formula = forall->formula->Replace(*forall->variable, *instances[i]);
+						if (new__sequent->left.Find(formula) == -1) {
+							formula->SetInstantiationTime(old_sequent->depth + 1);
+							new__sequent->left.Add(formula, applied);
+							added++;
+						}
+					}
 					
-					if (new__sequent->left.Find(formula) == -1)
-						new__sequent->left.Add(formula, new__sequent->left.Get(left_formula));
+					// E-matching only instantiates with terms which are already in
+					// the branch, and a proof may need a term which is not there
+					// yet, or be found only by unification. The instance with a
+					// fresh unification term is the rule of the plain calculus, so
+					// for completeness it is added whenever no matched instance is
+					// new, and in any case on every second application: the
+					// matched instances can introduce new terms forever, and then
+					// the general instance would never be added otherwise. This
+					// keeps the search fair, every formula gets it within two
+					// applications of the rule.
+					if (!added || applied % 2 == 0) {
+						NodeVar unterm = new UnificationTerm(old_sequent->GetVariableName("t"));
+						NodeVar formula = forall->formula->Replace(*forall->variable, *unterm);
+						formula->SetInstantiationTime(old_sequent->depth + 1);
+						
+						if (new__sequent->left.Find(formula) == -1)
+							new__sequent->left.Add(formula, applied);
+					}
+					SortByKey(new__sequent->left, NodeVar());
 
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -606,7 +728,7 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->left, formula) = (old_sequent->left.Get(left_formula) + 1);
 					SortByKey(new__sequent->left, NodeVar());
 					
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -629,7 +751,7 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->left, not_->formula) = (old_sequent->right.Get(right_formula) + 1);
 					SortByKey(new__sequent->left, NodeVar());
 					
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -657,13 +779,13 @@ bool ProveSequent(Node& sequent_) {
 					SortByKey(new__sequent_a->right, NodeVar());
 					SortByKey(new__sequent_b->right, NodeVar());
 					
-					if (new__sequent_a->siblings.GetCount())
-						new__sequent_a->siblings.Insert(0, new__sequent_a);
+					if (GetCount(new__sequent_a->siblings))
+						new__sequent_a->siblings = Join(new__sequent_a->siblings, new__sequent_a);
 
 					frontier.Add(new__sequent_a);
 
-					if (new__sequent_b->siblings.GetCount())
-						new__sequent_b->siblings.Insert(0, new__sequent_b);
+					if (GetCount(new__sequent_b->siblings))
+						new__sequent_b->siblings = Join(new__sequent_b->siblings, new__sequent_b);
 
 					frontier.Add(new__sequent_b);
 					break;
@@ -683,7 +805,7 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->right, or_->formula_b) = old_sequent->right.Get(right_formula) + 1;
 					SortByKey(new__sequent->right, NodeVar());
 					
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -704,7 +826,7 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->right, implies->formula_b) = old_sequent->right.Get(right_formula) + 1;
 					SortByKey(new__sequent->right, NodeVar());
 					
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -727,7 +849,7 @@ bool ProveSequent(Node& sequent_) {
 					GetInsert(new__sequent->right, formula) = old_sequent->right.Get(right_formula) + 1;
 					SortByKey(new__sequent->right, NodeVar());
 					
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -751,7 +873,7 @@ bool ProveSequent(Node& sequent_) {
 					if (new__sequent->right.Find(formula) == -1)
 						new__sequent->right.Insert(0, formula, new__sequent->right.Get(right_formula));
 					SortByKey(new__sequent->right, NodeVar());
-					new__sequent->siblings.Insert(0, new__sequent);
+					new__sequent->siblings = Join(new__sequent->siblings, new__sequent);
 
 					frontier.Add(new__sequent);
 					new__sequent->Dec();
@@ -759,6 +881,13 @@ bool ProveSequent(Node& sequent_) {
 				}
 			}
 		}
+		
+		for(int i = frontier_count; i < frontier.GetCount(); i++) {
+			Sequent* child = frontier[i].Get<Sequent>();
+			child->parent_step = step;
+			child->ground << old_sequent->ground;
+			proof.AddChild(step, proof.AddSequent(frontier[i], child->left, child->right));
+		}
 	}
 
 	// no more sequents to prove
@@ -767,51 +896,92 @@ bool ProveSequent(Node& sequent_) {
 
 // returns true if the formula == provable
 // returns false || loops forever if the formula != provable
-bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula) {
-	ArrayMap<NodeVar, int> left, right;
-	for(int i = 0; i < axioms.GetCount(); i++)
-		left.Add(axioms[i], 0);
-	right.Add(formula, 0);
-	NodeVar seq(new Sequent(left, right, Index<NodeVar>(), 0));
-	return ProveSequent(*seq);
-}
-
-extern String* catch_print;
-extern Index<NodeVar> axioms;
-extern ArrayMap<NodeVar, Index<NodeVar> > lemmas;
-
-String ProveLogicNode(NodeVar formula) {
-	String out;
-	if (!formula.Is()) return out;
-	
-	catch_print = &out;
+// model_limit is the time in ms of the countermodel search, 0 disables it
+bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula, Proof& proof, int engine, int time_limit, int model_limit) {
+	proof.Clear();
 	
-	CheckFormula ( *formula );
-	Index<NodeVar> tmp;
+	// A search of registered nodes runs in the region of the proof. The
+	// nodes of a free search are deleted with their last reference, and the
+	// cycles of its sequents are collected when it ends.
+	bool free_nodes = !GetContext();
+	RegionScope scope(free_nodes ? NULL : &proof.region);
+	proof.engine = engine;
+	if (time_limit > 0)
+		proof.deadline = msecs() + time_limit;
 	for(int i = 0; i < axioms.GetCount(); i++)
-		tmp.Add(axioms[i]);
-	for(int i = 0; i < lemmas.GetCount(); i++) {
-		int j = tmp.Find(lemmas.GetKey(i));
-		if (j == -1) tmp.Add(lemmas.GetKey(i));
-	}
+		proof.axioms.Add(axioms[i]);
+	proof.goal = formula;
 	
-	bool result = ProveFormula ( tmp, formula );
-	ASSERT(formula.GetNode());
+	// only the connection engine and the model finder read the clauses
+	ClauseSet& clauses = proof.clauses;
+	if (engine == ENGINE_CONNECTION || model_limit > 0)
+		Clausify(axioms, formula, clauses);
 	
-	if ( result )
-		Print ( Format( "Formula proven: %s.", formula->ToString() ));
-	else
-		Print ( Format( "Formula unprovable: %s.", formula->ToString() ));
+	TRACESUMMARY(Format("Proving %s from %d axioms (%d clauses)", formula->ToString(), axioms.GetCount(), clauses.clauses.GetCount()));
 	
-	catch_print = 0;
+	// A small countermodel settles a non-theorem, so the model finder runs
+	// next to the search, within a budget of its own, and the first of them
+	// to answer cancels the other. When the pool has no free thread, the
+	// finder runs only after a search which did not find a proof.
+	Atomic cancel_search, cancel_model;
+	cancel_search = 0;
+	cancel_model = 0;
+	bool countermodel = false;
+	ModelOptions model_opt;
+	CoWork co;
+	if (model_limit > 0) {
+		model_opt.deadline = msecs() + model_limit;
+		if (proof.deadline && proof.deadline - model_opt.deadline < 0)
+			model_opt.deadline = proof.deadline;
+		model_opt.cancel = &cancel_model;
+		co & [&] {
+			countermodel = FindModel(clauses, proof.model, model_opt);
+			if (countermodel)
+				cancel_search = 1;
+		};
+	}
+	
+	if (engine == ENGINE_CONNECTION) {
+		ConnectionOptions opt;
+		opt.deadline = proof.deadline;
+		opt.cancel = &cancel_search;
+		proof.connection = ProveConnection(clauses, opt);
+		proof.proven = proof.connection.proven;
+		proof.timeout = proof.connection.timeout;
+		TRACESUMMARY(Format("Connection search %s with path limit %d (%d inferences)",
+			proof.proven ? "succeeded" : "failed", proof.connection.path_limit, proof.connection.inferences));
+	}
+	else {
+		ArrayMap<NodeVar, int> left, right;
+		for(int i = 0; i < axioms.GetCount(); i++)
+			left.Add(axioms[i], 0);
+		right.Add(formula, 0);
+		NodeVar seq(new Sequent(left, right, SiblingListVar(), 0));
+		proof.cancel = &cancel_search;
+		proof.proven = ProveSequent(*seq, proof);
+		proof.cancel = NULL;
+		if (free_nodes) {
+			seq.Clear();
+			CollectCycles();
+		}
+		TRACESUMMARY(Format("Sequent search %s after %d steps", proof.proven ? "succeeded" : "failed", proof.steps.GetCount()));
+	}
 	
-	return out;
+	if (proof.proven)
+		cancel_model = 1;
+	co.Finish();
+	if (countermodel) {
+		// a search canceled by the countermodel did not run out of time
+		proof.timeout = false;
+		proof.connection.timeout = false;
+		TRACESUMMARY(Format("Countermodel of size %d found", proof.model.size));
+	}
+	return proof.proven;
 }
 
-String ProveLogic(String str) {
-	NodeVar n = Parse(str);
-	if (n.Is()) return ProveLogicNode(n);
-	return "";
+bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula, int engine) {
+	Proof proof;
+	return ProveFormula(axioms, formula, proof, engine);
 }
 
 }
@@ -0,0 +1,338 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+SatSolver::SatSolver() {
+	qhead = 0;
+	var_inc = 1.0;
+	unsat = false;
+	conflicts = 0;
+}
+
+int SatSolver::NewVar() {
+	int var = value.GetCount();
+	value.Add(SAT_UNKNOWN);
+	phase.Add(false);
+	level.Add(0);
+	reason.Add(-1);
+	activity.Add(0.0);
+	heap_pos.Add(-1);
+	seen.Add(false);
+	watches.Add();
+	watches.Add();
+	HeapInsert(var);
+	return var;
+}
+
+int SatSolver::GetLitValue(int lit) const {
+	int v = value[lit >> 1];
+	if (v == SAT_UNKNOWN)
+		return SAT_UNKNOWN;
+	return (lit & 1) ? !v : v;
+}
+
+void SatSolver::Enqueue(int lit, int from) {
+	int var = lit >> 1;
+	value[var] = (lit & 1) ? SAT_FALSE : SAT_TRUE;
+	level[var] = trail_lim.GetCount();
+	reason[var] = from;
+	trail.Add(lit);
+}
+
+// returns the conflicting clause or -1
+int SatSolver::Propagate() {
+	while (qhead < trail.GetCount()) {
+		int false_lit = trail[qhead++] ^ 1;
+		Vector<int>& ws = watches[false_lit];
+		int i = 0, j = 0;
+
+		while (i < ws.GetCount()) {
+			int ci = ws[i++];
+			const SatClause& c = clauses[ci];
+			int* l = &lits[c.first];
+
+			if (l[0] == false_lit)
+				Swap(l[0], l[1]);
+			if (GetLitValue(l[0]) == SAT_TRUE) {
+				ws[j++] = ci;
+				continue;
+			}
+
+			bool moved = false;
+			for(int k = 2; k < c.count; k++) {
+				if (GetLitValue(l[k]) != SAT_FALSE) {
+					Swap(l[1], l[k]);
+					watches[l[1]].Add(ci);
+					moved = true;
+					break;
+				}
+			}
+			if (moved)
+				continue;
+
+			ws[j++] = ci;
+			if (GetLitValue(l[0]) == SAT_FALSE) {
+				while (i < ws.GetCount())
+					ws[j++] = ws[i++];
+				ws.Trim(j);
+				return ci;
+			}
+			Enqueue(l[0], ci);
+		}
+		ws.Trim(j);
+	}
+	return -1;
+}
+
+// first UIP: the learnt clause has the asserting literal first and the literal of
+// the backjump level second
+void SatSolver::Analyze(int confl, Vector<int>& learnt, int& bt_level) {
+	learnt.Clear();
+	learnt.Add(-1);
+
+	int current = trail_lim.GetCount();
+	int counter = 0;
+	int p = -1;
+	int idx = trail.GetCount() - 1;
+
+	do {
+		const SatClause& c = clauses[confl];
+		for(int k = (p == -1 ? 0 : 1); k < c.count; k++) {
+			int q = lits[c.first + k];
+			int var = q >> 1;
+			if (seen[var] || level[var] == 0)
+				continue;
+			seen[var] = true;
+			Bump(var);
+			if (level[var] >= current)
+				counter++;
+			else
+				learnt.Add(q);
+		}
+
+		while (!seen[trail[idx] >> 1])
+			idx--;
+		p = trail[idx--];
+		confl = reason[p >> 1];
+		seen[p >> 1] = false;
+		counter--;
+	}
+	while (counter > 0);
+
+	learnt[0] = p ^ 1;
+
+	bt_level = 0;
+	int max_i = 1;
+	for(int i = 1; i < learnt.GetCount(); i++) {
+		int var = learnt[i] >> 1;
+		seen[var] = false;
+		if (level[var] > bt_level) {
+			bt_level = level[var];
+			max_i = i;
+		}
+	}
+	if (learnt.GetCount() > 1)
+		Swap(learnt[1], learnt[max_i]);
+}
+
+void SatSolver::Backjump(int lvl) {
+	if (trail_lim.GetCount() <= lvl)
+		return;
+
+	int stop = trail_lim[lvl];
+	for(int i = trail.GetCount() - 1; i >= stop; i--) {
+		int var = trail[i] >> 1;
+		phase[var] = value[var] == SAT_TRUE;
+		value[var] = SAT_UNKNOWN;
+		reason[var] = -1;
+		HeapInsert(var);
+	}
+	trail.Trim(stop);
+	trail_lim.Trim(lvl);
+	qhead = trail.GetCount();
+}
+
+int SatSolver::AddClauseRaw(const Vector<int>& c, bool learnt) {
+	SatClause& sc = clauses.Add();
+	sc.first = lits.GetCount();
+	sc.count = c.GetCount();
+	sc.learnt = learnt;
+	lits.Append(c);
+
+	int ci = clauses.GetCount() - 1;
+	watches[c[0]].Add(ci);
+	watches[c[1]].Add(ci);
+	return ci;
+}
+
+bool SatSolver::AddClause(const Vector<int>& c) {
+	if (unsat)
+		return false;
+	Backjump(0);
+
+	Vector<int> tmp;
+	tmp <<= c;
+	Sort(tmp);
+
+	Vector<int> out;
+	for(int i = 0; i < tmp.GetCount(); i++) {
+		int lit = tmp[i];
+		if (i > 0 && tmp[i - 1] == lit)
+			continue;
+		if (i > 0 && tmp[i - 1] == (lit ^ 1))
+			return true;
+		int v = GetLitValue(lit);
+		if (v == SAT_TRUE)
+			return true;
+		if (v == SAT_FALSE)
+			continue;
+		out.Add(lit);
+	}
+
+	if (out.IsEmpty()) {
+		unsat = true;
+		return false;
+	}
+
+	if (out.GetCount() == 1) {
+		Enqueue(out[0], -1);
+		if (Propagate() != -1) {
+			unsat = true;
+			return false;
+		}
+		return true;
+	}
+
+	AddClauseRaw(out, false);
+	return true;
+}
+
+void SatSolver::Bump(int var) {
+	activity[var] += var_inc;
+	if (activity[var] > 1e100) {
+		for(int i = 0; i < activity.GetCount(); i++)
+			activity[i] *= 1e-100;
+		var_inc *= 1e-100;
+	}
+	if (heap_pos[var] >= 0)
+		HeapUp(heap_pos[var]);
+}
+
+void SatSolver::HeapUp(int i) {
+	int var = heap[i];
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (activity[heap[parent]] >= activity[var])
+			break;
+		heap[i] = heap[parent];
+		heap_pos[heap[i]] = i;
+		i = parent;
+	}
+	heap[i] = var;
+	heap_pos[var] = i;
+}
+
+void SatSolver::HeapDown(int i) {
+	int var = heap[i];
+	int n = heap.GetCount();
+	while (true) {
+		int child = 2 * i + 1;
+		if (child >= n)
+			break;
+		if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]])
+			child++;
+		if (activity[heap[child]] <= activity[var])
+			break;
+		heap[i] = heap[child];
+		heap_pos[heap[i]] = i;
+		i = child;
+	}
+	heap[i] = var;
+	heap_pos[var] = i;
+}
+
+void SatSolver::HeapInsert(int var) {
+	if (heap_pos[var] >= 0)
+		return;
+	heap.Add(var);
+	HeapUp(heap.GetCount() - 1);
+}
+
+int SatSolver::HeapPop() {
+	int top = heap[0];
+	int last = heap.Pop();
+	heap_pos[top] = -1;
+	if (!heap.IsEmpty()) {
+		heap[0] = last;
+		HeapDown(0);
+	}
+	return top;
+}
+
+int SatSolver::PickBranch() {
+	while (!heap.IsEmpty()) {
+		int var = HeapPop();
+		if (value[var] == SAT_UNKNOWN)
+			return SatLit(var, !phase[var]);
+	}
+	return -1;
+}
+
+int SatSolver::Solve(int64 conflict_limit, int deadline, const Atomic* cancel) {
+	if (unsat)
+		return SAT_FALSE;
+
+	Backjump(0);
+	if (Propagate() != -1) {
+		unsat = true;
+		return SAT_FALSE;
+	}
+
+	int64 limit = conflict_limit < 0 ? -1 : conflicts + conflict_limit;
+	int64 restart = 100, since_restart = 0;
+	Vector<int> learnt;
+
+	while (true) {
+		int confl = Propagate();
+
+		if (confl >= 0) {
+			conflicts++;
+			since_restart++;
+			if (trail_lim.IsEmpty()) {
+				unsat = true;
+				return SAT_FALSE;
+			}
+
+			int bt_level;
+			Analyze(confl, learnt, bt_level);
+			Backjump(bt_level);
+			if (learnt.GetCount() == 1)
+				Enqueue(learnt[0], -1);
+			else
+				Enqueue(learnt[0], AddClauseRaw(learnt, true));
+			var_inc /= 0.95;
+
+			if ((limit >= 0 && conflicts >= limit) ||
+			    ((conflicts & 255) == 0 && ((deadline && msecs(deadline) >= 0) || (cancel && *cancel)))) {
+				Backjump(0);
+				return SAT_UNKNOWN;
+			}
+			continue;
+		}
+
+		if (since_restart >= restart) {
+			since_restart = 0;
+			restart = restart * 3 / 2;
+			Backjump(0);
+			continue;
+		}
+
+		int lit = PickBranch();
+		if (lit < 0)
+			return SAT_TRUE;
+		trail_lim.Add(trail.GetCount());
+		Enqueue(lit, -1);
+	}
+}
+
+}
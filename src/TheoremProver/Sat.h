@@ -0,0 +1,74 @@
+#ifndef _TheoremProver_Sat_h_
+#define _TheoremProver_Sat_h_
+
+namespace TheoremProver {
+
+/*
+	Small CDCL SAT solver for the finite model finder.
+
+	Literals are encoded as 2 * var + sign, where sign 1 means negated.
+	Two watched literals, first UIP clause learning, activity based decisions,
+	phase saving and geometric restarts.
+*/
+
+enum {
+	SAT_UNKNOWN = -1,
+	SAT_FALSE,
+	SAT_TRUE
+};
+
+inline int SatLit(int var, bool negative) {return var * 2 + (negative ? 1 : 0);}
+
+class SatSolver {
+
+	struct SatClause : Moveable<SatClause> {
+		int first, count;
+		bool learnt;
+	};
+
+	Vector<int> lits;
+	Vector<SatClause> clauses;
+	Vector<Vector<int> > watches;
+
+	Vector<signed char> value;
+	Vector<bool> phase;
+	Vector<int> level, reason;
+	Vector<int> trail, trail_lim;
+	int qhead;
+
+	Vector<double> activity;
+	Vector<int> heap, heap_pos;
+	double var_inc;
+
+	Vector<bool> seen;
+	bool unsat;
+	int64 conflicts;
+
+	int  GetLitValue(int lit) const;
+	void Enqueue(int lit, int from);
+	int  Propagate();
+	void Analyze(int confl, Vector<int>& learnt, int& bt_level);
+	void Backjump(int lvl);
+	int  AddClauseRaw(const Vector<int>& c, bool learnt);
+	void Bump(int var);
+	void HeapUp(int i);
+	void HeapDown(int i);
+	void HeapInsert(int var);
+	int  HeapPop();
+	int  PickBranch();
+
+public:
+	SatSolver();
+
+	int  NewVar();
+	int  GetVarCount() const {return value.GetCount();}
+	bool AddClause(const Vector<int>& c);
+	int  Solve(int64 conflict_limit = -1, int deadline = 0, const Atomic* cancel = NULL);
+	bool GetValue(int var) const {return value[var] == SAT_TRUE;}
+	int64 GetConflicts() const {return conflicts;}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,334 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+ProverServer::ProverServer(Stream& out, const ServerOptions& opt) :
+	out(out), opt(opt), version(0), running(0), proofs(0), cache_hits(0), quit(false) {
+	int threads = opt.threads > 0 ? opt.threads : CPU_Cores();
+	for(int i = 0; i < threads; i++)
+		workers.Add().Run([this] {WorkerLoop();});
+}
+
+ProverServer::~ProverServer() {
+	Finish();
+}
+
+void ProverServer::Finish() {
+	{
+		Mutex::Lock __(lock);
+		quit = true;
+	}
+	wake.Broadcast();
+	for(int i = 0; i < workers.GetCount(); i++)
+		workers[i].Wait();
+	workers.Clear();
+}
+
+void ProverServer::Write(const Value& id, Json& json) {
+	if (!IsNull(id))
+		json("id", id);
+	Mutex::Lock __(out_lock);
+	out << ~json << "\n";
+	out.Flush();
+}
+
+void ProverServer::Error(const Value& id, const String& msg) {
+	Json json("ok", false);
+	json("error", msg);
+	Write(id, json);
+}
+
+void ProverServer::AddResult(Json& json, const Result& r) {
+	json("status", r.status)
+	    ("time_ms", r.time)
+	    ("expanded", r.expanded)
+	    ("unifications", r.unifications);
+	if (r.model.GetCount())
+		json("model", r.model);
+}
+
+// the formula is parsed into free nodes, which are deleted when it returns
+String ProverServer::Canonical(const String& formula) {
+	FreeNodeScope free_scope;
+	NodeVar n = UnsafeParse(formula);
+	CheckFormula ( *n );
+	return n->ToString();
+}
+
+void ProverServer::Changed() {
+	version++;
+	cache.Clear();
+}
+
+void ProverServer::Run(Stream& in) {
+	while (!in.IsEof()) {
+		String line = TrimBoth(in.GetLine());
+		if (line.GetCount() && !Request(line))
+			break;
+	}
+	Finish();
+}
+
+bool ProverServer::Request(const String& line) {
+	Value req = ParseJSON(line);
+	if (IsError(req) || !IsValueMap(req)) {
+		Error(Value(), "Invalid request: " + line);
+		return true;
+	}
+
+	Value id = req["id"];
+	String op = req["op"];
+	String formula = req["formula"];
+
+	try {
+		if (op == "prove" || op == "lemma") {
+			Enqueue(id, req, op == "lemma");
+		}
+		else if (op == "axiom") {
+			String key = Canonical(formula);
+			bool added = false;
+			{
+				Mutex::Lock __(lock);
+				if (axioms.Find(key) < 0) {
+					axioms.Add(key, formula);
+					Changed();
+					added = true;
+				}
+			}
+			Json json("ok", true);
+			json("added", added)("axiom", key);
+			Write(id, json);
+		}
+		else if (op == "remove") {
+			Remove(id, formula);
+		}
+		else if (op == "axioms" || op == "lemmas") {
+			JsonArray list;
+			{
+				Mutex::Lock __(lock);
+				if (op == "axioms")
+					for(int i = 0; i < axioms.GetCount(); i++)
+						list << axioms.GetKey(i);
+				else
+					for(int i = 0; i < lemmas.GetCount(); i++)
+						list << lemmas.GetKey(i);
+			}
+			Json json("ok", true);
+			json(~op, list);
+			Write(id, json);
+		}
+		else if (op == "reset") {
+			{
+				Mutex::Lock __(lock);
+				axioms.Clear();
+				lemmas.Clear();
+				Changed();
+			}
+			Json json("ok", true);
+			Write(id, json);
+		}
+		else if (op == "stats") {
+			Stats(id);
+		}
+		else if (op == "quit") {
+			Finish();
+			Json json("ok", true);
+			Write(id, json);
+			return false;
+		}
+		else
+			Error(id, Format("Unknown op: %s", op));
+	}
+	catch (InvalidInputError e) {
+		Error(id, e);
+	}
+	return true;
+}
+
+void ProverServer::Enqueue(const Value& id, const Value& req, bool lemma) {
+	String formula = req["formula"];
+	String key = Canonical(formula);
+
+	int engine = opt.engine;
+	String engine_name = req["engine"];
+	if (engine_name == "connection")
+		engine = ENGINE_CONNECTION;
+	else if (engine_name == "sequent")
+		engine = ENGINE_SEQUENT;
+	else if (engine_name.GetCount())
+		throw InvalidInputError ( Format( "Unknown engine: %s.", engine_name ) );
+
+	Value time_limit = req["time_limit"];
+
+	One<Job> job;
+	job.Create();
+	job->id = id;
+	job->lemma = lemma;
+	job->goal = formula;
+	job->engine = engine;
+	job->time_limit = IsNumber(time_limit) ? (int)time_limit : opt.time_limit;
+	job->key = Format("%d %d %s", engine, job->time_limit, key);
+
+	Mutex::Lock __(lock);
+	if (!lemma) {
+		int i = cache.Find(job->key);
+		if (i >= 0) {
+			cache_hits++;
+			Json json("ok", true);
+			AddResult(json, cache[i]);
+			json("cached", true);
+			Write(id, json);
+			return;
+		}
+	}
+
+	job->version = version;
+	for(int i = 0; i < axioms.GetCount(); i++) {
+		job->premises.Add(axioms[i]);
+		job->axioms.Add(axioms.GetKey(i));
+	}
+	for(int i = 0; i < lemmas.GetCount(); i++)
+		job->premises.Add(lemmas[i].text);
+
+	queue.Add(job.Detach());
+	wake.Signal();
+}
+
+void ProverServer::Remove(const Value& id, const String& formula) {
+	String key = Canonical(formula);
+	Json json("ok", true);
+	JsonArray removed;
+
+	Mutex::Lock __(lock);
+	int i = axioms.Find(key);
+	if (i >= 0) {
+		axioms.Remove(i);
+		for(int j = lemmas.GetCount() - 1; j >= 0; j--)
+			if (lemmas[j].axioms.Find(key) >= 0) {
+				removed << lemmas.GetKey(j);
+				lemmas.Remove(j);
+			}
+		json("removed", "axiom")("lemmas", removed);
+	}
+	else if ((i = lemmas.Find(key)) >= 0) {
+		lemmas.Remove(i);
+		json("removed", "lemma");
+	}
+	else
+		throw InvalidInputError ( Format( "Not an axiom or lemma: %s.", key ) );
+
+	Changed();
+	Write(id, json);
+}
+
+void ProverServer::Stats(const Value& id) {
+	Json json("ok", true);
+	Mutex::Lock __(lock);
+	json("axioms", axioms.GetCount())
+	    ("lemmas", lemmas.GetCount())
+	    ("threads", workers.GetCount())
+	    ("queued", queue.GetCount())
+	    ("running", running)
+	    ("proofs", proofs)
+	    ("cache_hits", cache_hits)
+	    ("cache_size", cache.GetCount());
+	Write(id, json);
+}
+
+void ProverServer::WorkerLoop() {
+	Worker w;
+	SessionScope __(w.session);
+	for(;;) {
+		One<Job> job;
+		{
+			Mutex::Lock __(lock);
+			while (queue.IsEmpty() && !quit)
+				wake.Wait(lock);
+			if (queue.IsEmpty())
+				break;
+			job.Attach(queue.Detach(0));
+			running++;
+		}
+
+		Prove(w, *job);
+
+		Mutex::Lock __(lock);
+		running--;
+		proofs++;
+	}
+}
+
+// the premises of an earlier version are reused, those which were removed
+// are released
+void ProverServer::ParsePremises(Worker& w, const Job& job) {
+	if (w.version == job.version)
+		return;
+	
+	VectorMap<String, NodeVar> parsed;
+	w.premises.Clear();
+	for(int i = 0; i < job.premises.GetCount(); i++) {
+		const String& text = job.premises[i];
+		if (parsed.Find(text) >= 0)
+			continue;
+		int j = w.parsed.Find(text);
+		NodeVar n = j >= 0 ? w.parsed[j] : UnsafeParse(text);
+		parsed.Add(text, n);
+		w.premises.FindAdd(n);
+	}
+	w.parsed = pick(parsed);
+	w.version = job.version;
+}
+
+void ProverServer::Prove(Worker& w, Job& job) {
+	Json json("ok", true);
+	try {
+		// The premises and the goal are free nodes, deleted with their last
+		// handle, and the search runs in the region of its proof, so nothing
+		// of a request is left in the context of the session.
+		NodeVar formula;
+		{
+			FreeNodeScope free_scope;
+			ParsePremises(w, job);
+			formula = UnsafeParse(job.goal);
+		}
+
+		int ts = msecs();
+		Proof proof;
+		bool proven = ProveFormula(w.premises, formula, proof, job.engine, job.time_limit, opt.model_limit);
+
+		Result r;
+		r.status = proof.GetStatus();
+		r.time = msecs(ts);
+		r.expanded = proof.GetStepCount(STEP_EXPAND);
+		r.unifications = job.engine == ENGINE_CONNECTION ? proof.connection.inferences : (int64)proof.unifications;
+		if (proof.model.size)
+			r.model = proof.model.ToString();
+		AddResult(json, r);
+
+		Mutex::Lock __(lock);
+		if (job.version == version && !proof.timeout)
+			cache.GetAdd(job.key) = r;
+
+		if (job.lemma) {
+			// a lemma is kept only if none of its axioms was removed meanwhile
+			bool added = proven && lemmas.Find(formula->ToString()) < 0;
+			for(int i = 0; added && i < job.axioms.GetCount(); i++)
+				added = axioms.Find(job.axioms[i]) >= 0;
+			if (added) {
+				Lemma& l = lemmas.Add(formula->ToString());
+				l.text = job.goal;
+				for(int i = 0; i < job.axioms.GetCount(); i++)
+					l.axioms.Add(job.axioms[i]);
+				Changed();
+			}
+			json("lemma", added);
+		}
+	}
+	catch (InvalidInputError e) {
+		json = Json("ok", false);
+		json("error", (String)e);
+	}
+	Write(job.id, json);
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef _TheoremProver_Server_h_
+#define _TheoremProver_Server_h_
+
+namespace TheoremProver {
+
+/*
+	Server mode.
+
+	Reads one JSON request per line and writes one JSON response per line.
+	The "id" of a request, if any, is copied to its response. Proofs run on
+	a pool of threads, so the responses of "prove" and "lemma" come in the
+	order the proofs end; every other request is answered before the next
+	line is read.
+
+		{"op": "prove", "formula": f, "engine": "sequent", "time_limit": ms}
+		{"op": "lemma", "formula": f}      prove f, then keep it as a lemma
+		{"op": "axiom", "formula": f}
+		{"op": "remove", "formula": f}     an axiom with its lemmas, or a lemma
+		{"op": "axioms"}, {"op": "lemmas"}, {"op": "reset"}, {"op": "stats"}
+		{"op": "quit"}
+
+	A proof uses the axioms and lemmas there were when its request was read.
+	They are kept as text between requests: every worker has its own
+	ProverSession, parses its own copy of a formula once and keeps it until
+	the formula is removed. The answers of "prove" are cached until
+	the axioms or lemmas change.
+*/
+
+struct ServerOptions {
+	int engine;
+	int time_limit;   // milliseconds per proof, 0 for none
+	int model_limit;  // milliseconds of the countermodel search per proof, 0 for none
+	int threads;      // 0 for one per core
+
+	ServerOptions() : engine(ENGINE_SEQUENT), time_limit(0), model_limit(1000), threads(0) {}
+};
+
+class ProverServer {
+	struct Lemma {
+		String        text;
+		Index<String> axioms;
+	};
+
+	struct Result : Moveable<Result> {
+		String status;
+		int    time;
+		int    expanded;
+		int64  unifications;
+		String model;
+	};
+
+	struct Job {
+		Value          id;
+		bool           lemma;
+		String         goal;
+		String         key;
+		int            engine;
+		int            time_limit;
+		int            version;
+		Vector<String> premises;
+		Vector<String> axioms;
+	};
+
+	struct Worker {
+		ProverSession session;
+		VectorMap<String, NodeVar> parsed;
+		Index<NodeVar> premises;
+		int version;
+
+		Worker() : version(-1) {}
+	};
+
+	Stream& out;
+	ServerOptions opt;
+
+	// shared state, guarded by 'lock'
+	Mutex lock;
+	ConditionVariable wake;
+	VectorMap<String, String> axioms;
+	ArrayMap<String, Lemma> lemmas;
+	VectorMap<String, Result> cache;
+	Array<Job> queue;
+	int version;
+	int running;
+	int64 proofs, cache_hits;
+	bool quit;
+
+	Mutex out_lock;
+	Array<Thread> workers;
+
+	void   Write(const Value& id, Json& json);
+	void   Error(const Value& id, const String& msg);
+	void   AddResult(Json& json, const Result& r);
+	String Canonical(const String& formula);
+	void   Changed();
+
+	bool   Request(const String& line);
+	void   Enqueue(const Value& id, const Value& req, bool lemma);
+	void   Remove(const Value& id, const String& formula);
+	void   Stats(const Value& id);
+	void   WorkerLoop();
+	void   ParsePremises(Worker& w, const Job& job);
+	void   Prove(Worker& w, Job& job);
+
+public:
+	ProverServer(Stream& out, const ServerOptions& opt = ServerOptions());
+	~ProverServer();
+
+	void Run(Stream& in);
+	void Finish();
+};
+
+}
+
+#endif
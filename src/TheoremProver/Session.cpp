@@ -0,0 +1,245 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+static thread_local ProverSession* current_session;
+static thread_local bool free_nodes;
+static thread_local RefContext* region;
+
+static ProverSession& GetDefaultSession() {
+	static ProverSession session(&Cout());
+	return session;
+}
+
+ProverSession& GetSession() {
+	return current_session ? *current_session : GetDefaultSession();
+}
+
+RefContext* GetContext() {
+	if (free_nodes)
+		return NULL;
+	if (region)
+		return region;
+	return GetSession().GetNodeContext();
+}
+
+void Print(String s) {
+	GetSession().Print(s);
+}
+
+SessionScope::SessionScope(ProverSession& session) {
+	prev = current_session;
+	current_session = &session;
+}
+
+SessionScope::~SessionScope() {
+	current_session = prev;
+}
+
+FreeNodeScope::FreeNodeScope() {
+	prev = free_nodes;
+	prev_alloc = SetThreadRegion(NULL);
+	free_nodes = true;
+}
+
+FreeNodeScope::~FreeNodeScope() {
+	free_nodes = prev;
+	SetThreadRegion(prev_alloc);
+}
+
+// a context which is not a region, such as the one of a loader chunk,
+// takes the nodes allocated from the pool
+RegionScope::RegionScope(RefContext* r) {
+	prev = region;
+	prev_free = free_nodes;
+	prev_alloc = GetThreadRegion();
+	if (r) {
+		region = r;
+		free_nodes = false;
+		SetThreadRegion(r->IsRegion() ? r : NULL);
+	}
+}
+
+RegionScope::~RegionScope() {
+	region = prev;
+	free_nodes = prev_free;
+	SetThreadRegion(prev_alloc);
+}
+
+ProverSession::ProverSession(Stream* out)
+	: out(out), capture(0), register_nodes(true), trace_level(TRACE_OFF), trace_sink(0), engine(ENGINE_SEQUENT) {
+	
+}
+
+ProverSession::~ProverSession() {
+	ASSERT(current_session != this);
+}
+
+void ProverSession::Print(const String& s) {
+	if (capture) {*capture << s << "\n";}
+	if (out) {*out << s << EOL;}
+}
+
+void ProverSession::GetPremises(Index<NodeVar>& premises) const {
+	for(int i = 0; i < axioms.GetCount(); i++)
+		premises.FindAdd(axioms[i]);
+	for(int i = 0; i < lemmas.GetCount(); i++)
+		premises.FindAdd(lemmas.GetKey(i));
+}
+
+void ProverSession::Clear() {
+	axioms.Clear();
+	lemmas.Clear();
+}
+
+String ProverSession::AddAxiom(String str) {
+	SessionScope __(*this);
+	String out;
+	String* prev = capture;
+	capture = &out;
+	
+	NodeVar n = TheoremProver::Parse(str);
+	if (n.Is()) {
+		try {
+			CheckFormula ( *n );
+			axioms.Insert (0, n );
+		}
+		catch (InvalidInputError e) {
+			Print(e);
+		}
+	}
+	capture = prev;
+	return out;
+}
+
+// Same as AddAxiom of each formula in order, with one index build
+void ProverSession::AddAxioms(const Vector<NodeVar>& formulas) {
+	if (formulas.IsEmpty())
+		return;
+	
+	Index<NodeVar> kb;
+	kb.Reserve(formulas.GetCount() + axioms.GetCount());
+	for(int i = formulas.GetCount() - 1; i >= 0; i--)
+		kb.Add(formulas[i]);
+	for(int i = 0; i < axioms.GetCount(); i++)
+		kb.Add(axioms[i]);
+	axioms = pick(kb);
+}
+
+String ProverSession::GetAxioms() {
+	SessionScope __(*this);
+	String out;
+	String* prev = capture;
+	capture = &out;
+	
+	for(int i = 0; i < axioms.GetCount(); i++) {
+		const NodeVar& axiom = axioms[i];
+		Print(axiom->ToString());
+	}
+	
+	capture = prev;
+	return out;
+}
+
+String ProverSession::ProveLogicNode(NodeVar formula) {
+	String out;
+	if (!formula.Is()) return out;
+	
+	SessionScope __(*this);
+	String* prev = capture;
+	capture = &out;
+	
+	try {
+		CheckFormula ( *formula );
+		Index<NodeVar> tmp;
+		GetPremises(tmp);
+		
+		bool result = ProveFormula ( tmp, formula, last_proof, engine );
+		ASSERT(formula.GetNode());
+		out << last_proof.ToString();
+		
+		if ( result )
+			Print ( Format( "Formula proven: %s.", formula->ToString() ));
+		else
+			Print ( Format( "Formula %s: %s.", last_proof.GetVerdict(), formula->ToString() ));
+	}
+	catch (InvalidInputError e) {
+		Print(e);
+	}
+	
+	capture = prev;
+	return out;
+}
+
+String ProverSession::ProveLogic(String str) {
+	SessionScope __(*this);
+	NodeVar n = TheoremProver::Parse(str);
+	if (n.Is()) return ProveLogicNode(n);
+	return "";
+}
+
+String ProverSession::ProveLemmaNode(NodeVar formula) {
+	SessionScope __(*this);
+	String out;
+	String* prev = capture;
+	capture = &out;
+	
+	Index<NodeVar> tmp;
+	GetPremises(tmp);
+	
+	bool result = ProveFormula ( tmp, formula, last_proof, engine );
+	out << last_proof.ToString();
+
+	if ( result ) {
+		lemmas.GetAdd(last_proof.Promote(formula)) <<= axioms;
+		Print ( Format( "Lemma proven: %s.", formula->ToString() ));
+	}
+	else
+		Print ( Format( "Lemma %s: %s.", last_proof.GetVerdict(), formula->ToString() ));
+	
+	capture = prev;
+	return out;
+}
+
+String ProverSession::ProveLemma(String str) {
+	SessionScope __(*this);
+	NodeVar n = TheoremProver::Parse(str);
+	if (n.Is()) {
+		try {
+			CheckFormula ( *n );
+			return ProveLemmaNode(n);
+		}
+		catch (InvalidInputError e) {
+			Print(e);
+		}
+	}
+	return "";
+}
+
+String ProverSession::GetLemmas() {
+	SessionScope __(*this);
+	String out;
+	String* prev = capture;
+	capture = &out;
+	
+	for(int i = 0; i < lemmas.GetCount(); i++) {
+		const NodeVar& lemma = lemmas.GetKey(i);
+		Print(lemma->ToString());
+	}
+	
+	capture = prev;
+	return out;
+}
+
+// The free functions work on the session of the calling thread
+
+void ClearLogic()                      {GetSession().Clear();}
+String AddAxiom(String str)            {return GetSession().AddAxiom(str);}
+String GetAxioms()                     {return GetSession().GetAxioms();}
+String ProveLogicNode(NodeVar formula) {return GetSession().ProveLogicNode(formula);}
+String ProveLogic(String str)          {return GetSession().ProveLogic(str);}
+String ProveLemmaNode(NodeVar formula) {return GetSession().ProveLemmaNode(formula);}
+String ProveLemma(String str)          {return GetSession().ProveLemma(str);}
+String GetLemmas()                     {return GetSession().GetLemmas();}
+
+}
@@ -0,0 +1,126 @@
+#ifndef _TheoremProver_Session_h_
+#define _TheoremProver_Session_h_
+
+namespace TheoremProver {
+
+/*
+	Prover session.
+
+	A session owns a knowledge base of axioms and lemmas, the output of its
+	commands, its trace level and sink and the node context its formulas are
+	allocated in. A session is
+	entered on a thread with SessionScope: until the scope ends, new nodes go
+	to its context and Print writes to its output. The methods of a session
+	enter it by themselves. Threads which have not entered a session use the
+	default session of the process, which prints to Cout, and the free
+	functions AddAxiom, ProveLogic, ... work on the session of the calling
+	thread.
+
+	Sessions on different threads are independent and can prove at the same
+	time. A formula belongs to the session it was created in and must not be
+	used in another one.
+
+	Registering a node in the context takes a slot of its array, and the
+	slot is given back on destruction, both in constant time under the lock
+	of the context. Nodes created while the session does not register nodes,
+	or inside a FreeNodeScope, skip the context and are deleted with their
+	last reference, which also returns their memory at once. Free nodes in a
+	reference cycle, such as the sequents of the search which list
+	themselves among their siblings, are kept until the cycle collector
+	finds them unreachable at the end of a proof.
+
+	A RegionScope registers the nodes in another context, such as the region
+	of a Proof, until it ends, whatever the session does. When the context
+	is a region, the nodes are also allocated in its memory and are not
+	counted. ProveFormula runs a search of registered nodes in the region of
+	its proof, so the nodes of the search, cycles included, are destroyed
+	together with its record and their memory is freed in one step. A
+	search of free nodes leaves the cycles of its sequents to the cycle
+	collector of RefCore, which runs when the search ends and when its
+	proof is cleared.
+*/
+
+class ProverSession {
+	// destroyed last, after every node of the members below
+	RefContext ctx;
+
+	Stream* out;
+	String* capture;
+	bool register_nodes;
+	int trace_level;
+	TraceSink* trace_sink;
+
+	friend class SessionScope;
+
+public:
+	Index<NodeVar> axioms;
+	ArrayMap<NodeVar, Index<NodeVar> > lemmas;
+	int engine;
+	Proof last_proof;
+
+	ProverSession(Stream* out = NULL);
+	~ProverSession();
+
+	RefContext& GetContext() {return ctx;}
+	RefContext* GetNodeContext() {return register_nodes ? &ctx : NULL;}
+	void SetRegisterNodes(bool b) {register_nodes = b;}
+	bool IsRegisterNodes() const {return register_nodes;}
+	void SetOutput(Stream* s) {out = s;}
+	int GetTraceLevel() const {return trace_level;}
+	void SetTraceLevel(int level) {trace_level = level;}
+	TraceSink* GetTraceSink() const {return trace_sink;}
+	void SetTraceSink(TraceSink* sink) {trace_sink = sink;}
+	void Print(const String& s);
+
+	void GetPremises(Index<NodeVar>& premises) const;
+	void Clear();
+
+	String AddAxiom(String str);
+	void AddAxioms(const Vector<NodeVar>& formulas);
+	String GetAxioms();
+	String ProveLogicNode(NodeVar formula);
+	String ProveLogic(String str);
+	String ProveLemmaNode(NodeVar formula);
+	String ProveLemma(String str);
+	String GetLemmas();
+
+};
+
+class SessionScope {
+	ProverSession* prev;
+
+public:
+	SessionScope(ProverSession& session);
+	~SessionScope();
+
+};
+
+// Nodes created on this thread while the scope is alive are not registered
+class FreeNodeScope {
+	bool prev;
+	RefContext* prev_alloc;
+
+public:
+	FreeNodeScope();
+	~FreeNodeScope();
+
+};
+
+// Nodes created on this thread while the scope is alive are registered in
+// the region. A NULL region leaves the thread as it is.
+class RegionScope {
+	RefContext* prev;
+	bool prev_free;
+	RefContext* prev_alloc;
+
+public:
+	RegionScope(RefContext* region);
+	~RegionScope();
+
+};
+
+ProverSession& GetSession();
+
+}
+
+#endif
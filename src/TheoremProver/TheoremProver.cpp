@@ -3,20 +3,18 @@
 
 namespace TheoremProver {
 
-String* catch_print;
-
-void Print(String s) {
-	if (catch_print) {*catch_print << s << "\n";}
-	Cout() << s << EOL;
-	LOG(s);
+static void PrintTrace(String msg) {
+	Cout() << msg << EOL;
 }
 
 
-Index<NodeVar> axioms;
-ArrayMap<NodeVar, Index<NodeVar> > lemmas;
-
-
 void LogicCLI() {
+	ProverSession& session = GetSession();
+	Index<NodeVar>& axioms = session.axioms;
+	ArrayMap<NodeVar, Index<NodeVar> >& lemmas = session.lemmas;
+	int& engine = session.engine;
+	Proof& last_proof = session.last_proof;
+	
 	Print ( "First-Order Logic Theorem Prover" );
 	Print ( "" );
 	Print ( "Common commands:" );
@@ -45,6 +43,15 @@ void LogicCLI() {
 	Print ( "  lemma <formula>     (prove && add a lemma)" );
 	Print ( "  remove <formula>    (remove an axiom or lemma)" );
 	Print ( "  reset               (remove all axioms and lemmas)" );
+	Print ( "  engine <name>       (select the prover: sequent or connection)" );
+	Print ( "  proof               (show the proof search of the last formula)" );
+	Print ( "  certificate         (write the checkable certificate of the last formula)" );
+	Print ( "  trace <level>       (trace the search: off, summary, steps or debug)" );
+	Print ( "  tptp <file>         (prove a problem in TPTP fof or cnf format)" );
+	Print ( "  load <file>         (add the axioms of a file, one formula per line)" );
+	
+	CallbackTraceSink trace_sink(&PrintTrace);
+	SetTraceSink(&trace_sink);
 	
 	Vector<String> autocmds;
 	
@@ -73,6 +80,27 @@ void LogicCLI() {
 			
 			if (inp.GetCount() == 0) break;
 			
+			// file names are not tokenized
+			if (inp.StartsWith("tptp ")) {
+				String path = TrimBoth(inp.Mid(5));
+				TptpProblem problem;
+				LoadTptpFile(path, problem);
+				Print ( Format( "Loaded %d formulas, %d axioms.", problem.formulas, problem.axioms.GetCount() ));
+				
+				bool result = ProveFormula ( problem.axioms, problem.goal, last_proof, engine );
+				if ( !result && last_proof.model.size )
+					Print ( last_proof.model.ToString() );
+				Print ( Format( "%s: %s.", result ? "Theorem" : "Unproven", path ));
+				continue;
+			}
+			
+			if (inp.StartsWith("load ")) {
+				String path = TrimBoth(inp.Mid(5));
+				int count = LoadAxiomFile(path);
+				Print ( Format( "Loaded %d axioms.", count ));
+				continue;
+			}
+			
 			Index<String> commands;
 			commands.Add("axiom");
 			commands.Add("lemma");
@@ -80,28 +108,30 @@ void LogicCLI() {
 			commands.Add("lemmas");
 			commands.Add("remove");
 			commands.Add("reset");
+			commands.Add("engine");
+			commands.Add("proof");
+			commands.Add("certificate");
+			commands.Add("trace");
 			commands.Add("q");
 			commands.Add("quit");
 			
-			Vector<String> tokens = Lex(inp);
+			TokenList tokens;
+			tokens.Lex(inp);
+			String command;
 			for(int i = 0; i < tokens.GetCount(); i++) {
-				String& t = tokens[i];
-				String l = ToLower(t);
-				if (commands.Find(l) != -1)
-					tokens[i] = l;
-			}
-			
-			for(int i = 1; i < tokens.GetCount(); i++) {
-				String& token = tokens[i];
-				if ( commands.Find(token) != -1 )
+				String token = ToLower(tokens.GetText(i));
+				if (commands.Find(token) == -1)
+					continue;
+				if (i > 0)
 					throw InvalidInputError ( Format("Unexpected keyword: %s.", token) );
+				command = token;
 			}
 
-			if (tokens.GetCount() && (tokens[0] == "q" || tokens[0] == "quit")) {
+			if (command == "q" || command == "quit") {
 				break;
 			}
 			
-			if (tokens.GetCount() && tokens[0] == "examples") {
+			if (tokens.GetCount() && tokens.GetText(0) == "examples") {
 				//autocmds.Add("((a and not b) implies c) and ((not a) equals (b and c))");
 				autocmds.Add("P or not P");
 				autocmds.Add("P and not P");
@@ -114,38 +144,32 @@ void LogicCLI() {
 				autocmds.Add("remove forall x. Equals(x, x)");
 				
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "axioms" ) {
+			else if ( command == "axioms" ) {
 				if ( tokens.GetCount() > 1 )
-					throw InvalidInputError ( Format("Unexpected: %s.", tokens[1]) );
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(1)) );
 				
 				for(int i = 0; i < axioms.GetCount(); i++) {
 					const NodeVar& axiom = axioms[i];
 					Print(axiom->ToString());
 				}
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "lemmas" ) {
+			else if ( command == "lemmas" ) {
 				if ( tokens.GetCount() > 1 )
-					throw InvalidInputError ( Format("Unexpected: %s.", tokens[1]) );
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(1)) );
 				
 				for(int i = 0; i < lemmas.GetCount(); i++) {
 					const NodeVar& lemma = lemmas.GetKey(i);
 					Print(lemma->ToString());
 				}
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "axiom" ) {
-				Vector<String> tmp;
-				for(int i = 1; i < tokens.GetCount(); i++)
-					tmp.Add(tokens[i]);
-				NodeVar formula = Parse(tmp);
+			else if ( command == "axiom" ) {
+				NodeVar formula = Parse(tokens, 1);
 				CheckFormula ( *formula );
 				axioms.Insert (0, formula );
 				Print ( Format( "Axiom added: %s.", formula->ToString() ));
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "lemma" ) {
-				Vector<String> tmp1;
-				for(int i = 1; i < tokens.GetCount(); i++)
-					tmp1.Add(tokens[i]);
-				NodeVar formula = Parse(tmp1);
+			else if ( command == "lemma" ) {
+				NodeVar formula = Parse(tokens, 1);
 				CheckFormula ( *formula );
 				
 				Index<NodeVar> tmp2;
@@ -155,20 +179,20 @@ void LogicCLI() {
 					if (tmp2.Find(lemmas.GetKey(i)) == -1)
 						tmp2.Add(lemmas.GetKey(i));
 				
-				bool result = ProveFormula ( tmp2, formula );
+				bool result = ProveFormula ( tmp2, formula, last_proof, engine );
 
 				if ( result ) {
 					lemmas.GetAdd(formula) <<= axioms;
 					Print ( Format( "Lemma proven: %s.", formula->ToString() ));
 				}
-				else
-					Print ( Format( "Lemma unprovable: %s.", formula->ToString() ));
+				else {
+					if ( last_proof.model.size )
+						Print ( last_proof.model.ToString() );
+					Print ( Format( "Lemma %s: %s.", last_proof.GetVerdict(), formula->ToString() ));
+				}
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "remove" ) {
-				Vector<String> tmp;
-				for(int i = 1; i < tokens.GetCount(); i++)
-					tmp.Add(tokens[i]);
-				NodeVar formula = Parse(tmp);
+			else if ( command == "remove" ) {
+				NodeVar formula = Parse(tokens, 1);
 				CheckFormula ( *formula );
 				
 				int pos = axioms.Find(formula);
@@ -213,9 +237,56 @@ void LogicCLI() {
 				else
 					Print ( Format( "Not an axiom: %s.", formula->ToString() ));
 			}
-			else if ( tokens.GetCount() > 0 && tokens[0] == "reset" ) {
+			else if ( command == "proof" ) {
+				if ( tokens.GetCount() > 1 )
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(1)) );
+				
+				Cout() << last_proof.ToString();
+			}
+			else if ( command == "certificate" ) {
 				if ( tokens.GetCount() > 1 )
-					throw InvalidInputError ( Format("Unexpected: %s.", tokens[1]) );
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(1)) );
+				if ( !last_proof.goal.Is() )
+					throw InvalidInputError ( "No formula has been proven yet." );
+				
+				Cout() << last_proof.GetCertificate();
+			}
+			else if ( command == "engine" ) {
+				if ( tokens.GetCount() == 1 ) {
+					Print ( engine == ENGINE_CONNECTION ? "connection" : "sequent" );
+					continue;
+				}
+				if ( tokens.GetCount() > 2 )
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(2)) );
+				
+				String name = ToLower(tokens.GetText(1));
+				if ( name == "sequent" )
+					engine = ENGINE_SEQUENT;
+				else if ( name == "connection" )
+					engine = ENGINE_CONNECTION;
+				else
+					throw InvalidInputError ( Format("Unknown engine: %s.", tokens.GetText(1)) );
+				Print ( Format( "Engine: %s.", name ));
+			}
+			else if ( command == "trace" ) {
+				if ( tokens.GetCount() == 1 ) {
+					Print ( GetTraceLevelName(GetTraceLevel()) );
+					continue;
+				}
+				if ( tokens.GetCount() > 2 )
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(2)) );
+				
+				int level = FindTraceLevel(ToLower(tokens.GetText(1)));
+				if ( level < 0 )
+					throw InvalidInputError ( Format("Unknown trace level: %s.", tokens.GetText(1)) );
+				SetTraceLevel(level);
+				if ( GetTraceLevel() != level )
+					Print ( Format( "Trace level %s is not compiled in.", tokens.GetText(1) ));
+				Print ( Format( "Trace: %s.", GetTraceLevelName(GetTraceLevel()) ));
+			}
+			else if ( command == "reset" ) {
+				if ( tokens.GetCount() > 1 )
+					throw InvalidInputError ( Format("Unexpected: %s.", tokens.GetText(1)) );
 
 				axioms.Clear();
 				lemmas.Clear();
@@ -231,19 +302,24 @@ void LogicCLI() {
 					if (j == -1) tmp.Add(lemmas.GetKey(i));
 				}
 				
-				bool result = ProveFormula ( tmp, formula );
+				bool result = ProveFormula ( tmp, formula, last_proof, engine );
 				ASSERT(formula.GetNode());
 				
 				if ( result )
 					Print ( Format( "Formula proven: %s.", formula->ToString() ));
-				else
-					Print ( Format( "Formula unprovable: %s.", formula->ToString() ));
+				else {
+					if ( last_proof.model.size )
+						Print ( last_proof.model.ToString() );
+					Print ( Format( "Formula %s: %s.", last_proof.GetVerdict(), formula->ToString() ));
+				}
 			}
 		}
 		catch ( InvalidInputError e ) {
 			Print ( e );
 		}
 	}
+	
+	SetTraceSink(NULL);
 }
 
 }
@@ -251,9 +327,83 @@ void LogicCLI() {
 #ifdef flagMAIN
 using namespace TheoremProver;
 
+static int BatchCLI(const Vector<String>& cmd) {
+	String path;
+	BatchOptions opt;
+	bool server = false;
+	bool bad = false;
+	
+	for(int i = 0; i < cmd.GetCount(); i++) {
+		String a = cmd[i];
+		bool has_value = i + 1 < cmd.GetCount();
+		if (a == "-batch" && has_value)
+			path = cmd[++i];
+		else if (a == "-server")
+			server = true;
+		else if (a == "-j" && has_value)
+			opt.threads = atoi(cmd[++i]);
+		else if (a == "-t" && has_value)
+			opt.time_limit = atoi(cmd[++i]);
+		else if (a == "-m" && has_value)
+			opt.model_limit = atoi(cmd[++i]);
+		else if (a == "-engine" && has_value) {
+			String e = ToLower(cmd[++i]);
+			if (e == "connection")
+				opt.engine = ENGINE_CONNECTION;
+			else if (e != "sequent")
+				bad = true;
+		}
+		else
+			bad = true;
+	}
+	
+	// exactly one of -batch and -server
+	if (bad || server != path.IsEmpty()) {
+		Cerr() << "Usage: TheoremProver [-batch file | -server] [-j threads] [-t ms] [-m ms] [-engine sequent|connection]\n";
+		return 1;
+	}
+	
+	if (server) {
+		ServerOptions sopt;
+		sopt.engine = opt.engine;
+		sopt.time_limit = opt.time_limit;
+		sopt.model_limit = opt.model_limit;
+		sopt.threads = opt.threads;
+		ProverServer server(Cout(), sopt);
+		server.Run(Cin());
+		return 0;
+	}
+	
+	if (!FileExists(path)) {
+		Cerr() << "Unable to read " << path << "\n";
+		return 1;
+	}
+	
+	int ts = msecs();
+	VectorMap<String, int> totals;
+	try {
+		totals = ProveBatch(LoadFile(path), Cout(), opt);
+	}
+	catch (InvalidInputError e) {
+		Cerr() << path << ": " << e << "\n";
+		return 1;
+	}
+	
+	String summary = Format("%s: %d ms:", path, msecs(ts));
+	for(int i = 0; i < totals.GetCount(); i++)
+		summary << " " << totals[i] << " " << totals.GetKey(i);
+	Cerr() << summary << "\n";
+	return totals.Find("error") >= 0;
+}
+
 CONSOLE_APP_MAIN {
 	BreakNullVarDtor();
 	
+	if (CommandLine().GetCount()) {
+		SetExitCode(BatchCLI(CommandLine()));
+		return;
+	}
+	
 	LogicCLI();
 }
 #endif
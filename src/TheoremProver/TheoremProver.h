@@ -22,7 +22,20 @@ using namespace Upp;
 
 */
 
+#include "Trace.h"
 #include "Language.h"
+#include "Lexer.h"
+#include "Trigger.h"
+#include "Clause.h"
+#include "Connection.h"
+#include "Sat.h"
+#include "ModelFinder.h"
+#include "Proof.h"
+#include "Tptp.h"
+#include "Session.h"
+#include "Loader.h"
+#include "Batch.h"
+#include "Server.h"
 
 namespace TheoremProver {
 
@@ -33,12 +46,15 @@ public:
 };
 
 void Print(String s);
-bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula);
+bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula, Proof& proof, int engine = ENGINE_SEQUENT, int time_limit = 0, int model_limit = 1000);
+bool ProveFormula(const Index<NodeVar>& axioms, const NodeVar& formula, int engine = ENGINE_SEQUENT);
 void RemoveRef(ArrayMap<NodeVar, int>& ind, const NodeVar& ref);
+bool Unify(Node& term_a, Node& term_b, VectorMap<NodeVar, NodeVar>& out);
+bool UnifyList(const VectorMap<NodeVar, NodeVar>& pairs, VectorMap<NodeVar, NodeVar>& out);
+NodeVar CopyNode(Node& n);
 
 
-Vector<String> Lex(const String& inp);
-NodeVar Parse(Vector<String>& tokens);
+NodeVar Parse(const TokenList& tokens, int begin = 0);
 NodeVar Parse(String str);
 NodeVar UnsafeParse(String str);
 String EvaluateLogicNode(NodeVar ref);
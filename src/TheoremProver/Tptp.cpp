@@ -0,0 +1,669 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+enum {
+	TPTP_BUFFER_SIZE = 1 << 16,
+	TPTP_MAX_INCLUDE_DEPTH = 32
+};
+
+TptpParser::TptpParser() {
+	input.in = NULL;
+	input.pos = input.len = 0;
+	input.line = 1;
+	input.eof = true;
+	tk = TK_EOF;
+	include_depth = 0;
+	uses_true = uses_false = uses_equality = false;
+}
+
+
+// Reading
+
+void TptpParser::Fill() {
+	if (input.pos < input.len || input.eof)
+		return;
+	input.len = input.in->Get(input.buffer, TPTP_BUFFER_SIZE);
+	input.pos = 0;
+	if (input.len <= 0) {
+		input.len = 0;
+		input.eof = true;
+	}
+}
+
+int TptpParser::Peek() {
+	Fill();
+	return input.pos < input.len ? (byte)input.buffer[input.pos] : -1;
+}
+
+int TptpParser::Get() {
+	int chr = Peek();
+	if (chr >= 0) {
+		input.pos++;
+		if (chr == '\n')
+			input.line++;
+	}
+	return chr;
+}
+
+void TptpParser::Error(const String& msg) const {
+	throw InvalidInputError ( Format( "%s:%d: %s", input.source, input.line, msg ) );
+}
+
+void TptpParser::SkipSpace() {
+	while (true) {
+		int chr = Peek();
+
+		if (chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n') {
+			Get();
+			continue;
+		}
+
+		if (chr == '%') {
+			while (chr >= 0 && chr != '\n')
+				chr = Get();
+			continue;
+		}
+
+		if (chr == '/') {
+			Get();
+			if (Get() != '*')
+				Error("Unexpected \"/\".");
+			int prev = 0;
+			while (true) {
+				chr = Get();
+				if (chr < 0)
+					Error("Unterminated comment.");
+				if (prev == '*' && chr == '/')
+					break;
+				prev = chr;
+			}
+			continue;
+		}
+
+		break;
+	}
+}
+
+static bool IsWordChar(int chr) {return IsAlNum(chr) || chr == '_';}
+
+void TptpParser::Next() {
+	SkipSpace();
+	token.Clear();
+	int chr = Peek();
+
+	if (chr < 0) {
+		tk = TK_EOF;
+		return;
+	}
+
+	if (IsAlpha(chr) || chr == '$') {
+		tk = Upp::IsUpper(chr) ? TK_VARIABLE : chr == '$' ? TK_DEFINED : TK_WORD;
+		token.Cat(Get());
+		if (chr == '$' && Peek() == '$')
+			token.Cat(Get());
+		while (IsWordChar(Peek()))
+			token.Cat(Get());
+		return;
+	}
+
+	if (IsDigit(chr)) {
+		tk = TK_WORD;
+		while (IsDigit(Peek()) || Peek() == '/')
+			token.Cat(Get());
+		return;
+	}
+
+	if (chr == '\'' || chr == '\"') {
+		tk = TK_WORD;
+		Get();
+		String text;
+		while (true) {
+			int c = Get();
+			if (c < 0 || c == '\n')
+				Error("Unterminated quoted name.");
+			if (c == chr)
+				break;
+			if (c == '\\')
+				c = Get();
+			text.Cat(c);
+		}
+
+		// 'abc' is the same name as abc
+		bool plain = chr == '\'' && text.GetCount() && Upp::IsLower(text[0]);
+		for(int i = 0; i < text.GetCount() && plain; i++)
+			plain = IsWordChar(text[i]);
+		if (plain)
+			token = text;
+		else
+			token << (char)chr << text << (char)chr;
+		return;
+	}
+
+	tk = TK_PUNCT;
+	token.Cat(Get());
+
+	switch (chr) {
+	case '<':
+		if (Peek() == '=') {
+			token.Cat(Get());
+			if (Peek() == '>')
+				token.Cat(Get());
+		}
+		else if (Peek() == '~') {
+			token.Cat(Get());
+			if (Get() != '>')
+				Error("Invalid connective \"<~\".");
+			token.Cat('>');
+		}
+		break;
+	case '=':
+		if (Peek() == '>')
+			token.Cat(Get());
+		break;
+	case '~':
+		if (Peek() == '|' || Peek() == '&')
+			token.Cat(Get());
+		break;
+	case '!':
+		if (Peek() == '=')
+			token.Cat(Get());
+		break;
+	}
+}
+
+void TptpParser::Expect(const char* punct) {
+	if (!Is(punct))
+		Error(Format("Expected \"%s\" instead of \"%s\".", punct, tk == TK_EOF ? String("end of file") : token));
+	Next();
+}
+
+String TptpParser::ReadName() {
+	if (tk != TK_WORD)
+		Error(Format("Expected a name instead of \"%s\".", token));
+	String name = token;
+	Next();
+	return name;
+}
+
+// source and useful info terms are not needed by the prover
+void TptpParser::SkipAnnotation() {
+	int depth = 0;
+	while (tk != TK_EOF) {
+		if (Is("(") || Is("["))
+			depth++;
+		else if (Is(")") || Is("]")) {
+			if (!depth)
+				return;
+			depth--;
+		}
+		Next();
+	}
+	Error("Unexpected end of file in annotation.");
+}
+
+
+// Formulae
+
+NodeVar TptpParser::ParseFormula() {
+	NodeVar a = ParseUnitary();
+
+	// associative connectives
+	if (Is("&") || Is("|")) {
+		bool conjunction = Is("&");
+		while (conjunction ? Is("&") : Is("|")) {
+			Next();
+			NodeVar b = ParseUnitary();
+			if (conjunction)
+				a = new And(*a, *b);
+			else
+				a = new Or(*a, *b);
+		}
+		return a;
+	}
+
+	if (tk != TK_PUNCT)
+		return a;
+
+	String op = token;
+	if (op != "=>" && op != "<=" && op != "<=>" && op != "<~>" && op != "~|" && op != "~&")
+		return a;
+
+	Next();
+	NodeVar b = ParseUnitary();
+
+	if (op == "=>")
+		return new Implies(*a, *b);
+	if (op == "<=")
+		return new Implies(*b, *a);
+	if (op == "~|")
+		return new Not(*NodeVar(new Or(*a, *b)));
+	if (op == "~&")
+		return new Not(*NodeVar(new And(*a, *b)));
+
+	NodeVar equiv = new And(*NodeVar(new Implies(*a, *b)), *NodeVar(new Implies(*b, *a)));
+	if (op == "<~>")
+		return new Not(*equiv);
+	return equiv;
+}
+
+NodeVar TptpParser::ParseUnitary() {
+	if (Is("(")) {
+		Next();
+		NodeVar formula = ParseFormula();
+		Expect(")");
+		return formula;
+	}
+
+	if (Is("~")) {
+		Next();
+		return new Not(*ParseUnitary());
+	}
+
+	if (Is("!") || Is("?")) {
+		bool forall = Is("!");
+		Next();
+		Expect("[");
+
+		Vector<NodeVar> vars;
+		while (true) {
+			if (tk != TK_VARIABLE)
+				Error(Format("Expected a variable instead of \"%s\".", token));
+			vars.Add(new Variable(Intern(token)));
+			Next();
+			if (Is(":"))
+				Error("Typed variables are not supported.");
+			if (!Is(","))
+				break;
+			Next();
+		}
+		Expect("]");
+		Expect(":");
+
+		NodeVar formula = ParseUnitary();
+		for(int i = vars.GetCount() - 1; i >= 0; i--) {
+			if (forall)
+				formula = new ForAll(*vars[i], *formula);
+			else
+				formula = new ThereExists(*vars[i], *formula);
+		}
+		return formula;
+	}
+
+	return ParseAtom();
+}
+
+void TptpParser::ParseArgs(Index<NodeVar>& args) {
+	Expect("(");
+	while (true) {
+		args.Add(ParseTerm());
+		if (!Is(","))
+			break;
+		Next();
+	}
+	Expect(")");
+}
+
+NodeVar TptpParser::ParseTerm() {
+	if (tk == TK_VARIABLE) {
+		NodeVar var = new Variable(Intern(token));
+		Next();
+		return var;
+	}
+
+	if (tk != TK_WORD && tk != TK_DEFINED)
+		Error(Format("Expected a term instead of \"%s\".", tk == TK_EOF ? String("end of file") : token));
+
+	String name = Intern(token);
+	Next();
+
+	Index<NodeVar> args;
+	if (Is("("))
+		ParseArgs(args);
+	return new Function(name, args);
+}
+
+NodeVar TptpParser::ParseAtom() {
+	if (tk == TK_DEFINED && (token == "$true" || token == "$false")) {
+		if (token == "$true")
+			uses_true = true;
+		else
+			uses_false = true;
+		NodeVar atom = new Predicate(Intern(token), Index<NodeVar>());
+		Next();
+		return atom;
+	}
+
+	// a term on the left side of an equation or the arguments of a predicate
+	NodeVar left;
+	String name;
+	Index<NodeVar> args;
+
+	if (tk == TK_VARIABLE)
+		left = ParseTerm();
+	else if (tk == TK_WORD || tk == TK_DEFINED) {
+		name = Intern(token);
+		Next();
+		if (Is("("))
+			ParseArgs(args);
+	}
+	else
+		Error(Format("Expected a formula instead of \"%s\".", tk == TK_EOF ? String("end of file") : token));
+
+	if (Is("=") || Is("!=")) {
+		bool equal = Is("=");
+		uses_equality = true;
+		Next();
+		if (!left.Is())
+			left = new Function(name, args);
+
+		Index<NodeVar> terms;
+		terms.Add(left);
+		terms.Add(ParseTerm());
+		NodeVar atom = new Predicate(Intern("="), terms);
+		if (equal)
+			return atom;
+		return new Not(*atom);
+	}
+
+	if (left.Is())
+		Error(Format("Variable %s used as a formula.", left->GetName()));
+
+	return new Predicate(name, args);
+}
+
+// free variables of clauses are universally quantified
+NodeVar TptpParser::Close(NodeVar formula) {
+	Index<NodeVar> vars;
+	formula->FreeVariables(vars);
+	for(int i = vars.GetCount() - 1; i >= 0; i--)
+		formula = new ForAll(*vars[i], *formula);
+	return formula;
+}
+
+
+// Annotated formulae
+
+void TptpParser::ParseInclude() {
+	Expect("(");
+	if (tk != TK_WORD)
+		Error("Expected a file name in include.");
+	String path = token;
+	if (path.GetCount() && path[0] == '\'')
+		path = path.Mid(1, path.GetCount() - 2);
+	Next();
+
+	Index<String> selection;
+	bool selected = false;
+	if (Is(",")) {
+		Next();
+		Expect("[");
+		selected = true;
+		while (!Is("]")) {
+			selection.Add(ReadName());
+			if (!Is(","))
+				break;
+			Next();
+		}
+		Expect("]");
+	}
+	Expect(")");
+	if (!Is("."))
+		Error("Expected \".\" after include.");
+
+	// TPTP resolves includes from the problem library root
+	String found;
+	Vector<String> dirs;
+	dirs.Add(GetFileDirectory(input.source));
+	for(int i = 0; i < include_dirs.GetCount(); i++)
+		dirs.Add(include_dirs[i]);
+	String root = GetEnv("TPTP");
+	if (root.GetCount())
+		dirs.Add(root);
+
+	if (IsFullPath(path))
+		found = path;
+	for(int i = 0; i < dirs.GetCount() && found.IsEmpty(); i++) {
+		String p = AppendFileName(dirs[i], path);
+		if (FileExists(p))
+			found = p;
+	}
+	if (found.IsEmpty())
+		Error(Format("Included file not found: %s.", path));
+
+	ParseFile(found, selected ? &selection : NULL);
+}
+
+void TptpParser::ParseInput(const Index<String>* selection) {
+	Next();
+	while (tk != TK_EOF) {
+		if (tk != TK_WORD)
+			Error(Format("Expected an annotated formula instead of \"%s\".", token));
+
+		String kind = token;
+		Next();
+
+		if (kind == "include") {
+			ParseInclude();
+			Next();
+			continue;
+		}
+
+		if (kind != "fof" && kind != "cnf")
+			Error(Format("Unsupported formula language: %s.", kind));
+
+		TptpFormula f;
+		f.cnf = kind == "cnf";
+		Expect("(");
+		f.name = ReadName();
+		Expect(",");
+		f.role = ReadName();
+		Expect(",");
+		f.formula = Close(ParseFormula());
+		if (Is(",")) {
+			Next();
+			SkipAnnotation();
+		}
+		Expect(")");
+		if (!Is("."))
+			Error("Expected \".\" after the annotated formula.");
+
+		if (!selection || selection->Find(f.name) != -1)
+			WhenFormula(f);
+
+		Next();
+	}
+}
+
+void TptpParser::Parse(Stream& in, const String& source) {
+	Input saved = pick(input);
+	input.in = &in;
+	input.source = source;
+	input.buffer.Alloc(TPTP_BUFFER_SIZE);
+	input.pos = input.len = 0;
+	input.line = 1;
+	input.eof = false;
+
+	try {
+		ParseInput(NULL);
+	}
+	catch (...) {
+		input = pick(saved);
+		throw;
+	}
+	input = pick(saved);
+}
+
+void TptpParser::ParseFile(const String& path, const Index<String>* selection) {
+	if (include_depth >= TPTP_MAX_INCLUDE_DEPTH)
+		Error(Format("Includes nested too deeply: %s.", path));
+
+	FileIn in(path);
+	if (!in.IsOpen())
+		throw InvalidInputError ( Format( "Unable to open %s.", path ) );
+
+	Input saved = pick(input);
+	input.in = &in;
+	input.source = path;
+	input.buffer.Alloc(TPTP_BUFFER_SIZE);
+	input.pos = input.len = 0;
+	input.line = 1;
+	input.eof = false;
+	include_depth++;
+
+	try {
+		ParseInput(selection);
+	}
+	catch (...) {
+		include_depth--;
+		input = pick(saved);
+		throw;
+	}
+	include_depth--;
+	input = pick(saved);
+}
+
+
+// Problems
+
+struct TptpSignature {
+	Index<String>  keys;
+	Vector<String> names;
+	Vector<int>    arity;
+	Vector<bool>   predicate;
+};
+
+static void AddSymbols(Node& n, TptpSignature& sig) {
+	bool is_pred = dynamic_cast<Predicate*>(&n);
+	if (is_pred || dynamic_cast<Function*>(&n)) {
+		String key = (is_pred ? "P:" : "F:") + n.GetName() + "/" + IntStr(n.GetCount());
+		if (sig.keys.Find(key) == -1) {
+			sig.keys.Add(key);
+			sig.names.Add(n.GetName());
+			sig.arity.Add(n.GetCount());
+			sig.predicate.Add(is_pred);
+		}
+	}
+	for(int i = 0; i < n.GetCount(); i++)
+		AddSymbols(n[i], sig);
+}
+
+static NodeVar Equation(TptpParser& parser, const NodeVar& a, const NodeVar& b) {
+	Index<NodeVar> terms;
+	terms.Add(a);
+	terms.Add(b);
+	return new Predicate(parser.Intern("="), terms);
+}
+
+static NodeVar CloseAll(const Vector<NodeVar>& vars, NodeVar formula) {
+	for(int i = vars.GetCount() - 1; i >= 0; i--)
+		formula = new ForAll(*vars[i], *formula);
+	return formula;
+}
+
+// "=" is a predicate of the prover, so the axioms of equality are added:
+// reflexivity, symmetry, transitivity and the substitution of equals in each
+// argument of every function and predicate symbol
+static void AddEqualityAxioms(TptpParser& parser, TptpProblem& problem, const Vector<NodeVar>& conjectures) {
+	TptpSignature sig;
+	for(int i = 0; i < problem.axioms.GetCount(); i++)
+		AddSymbols(*problem.axioms[i], sig);
+	for(int i = 0; i < conjectures.GetCount(); i++)
+		AddSymbols(*conjectures[i], sig);
+
+	Vector<NodeVar> xyz;
+	xyz.Add(new Variable(parser.Intern("X")));
+	xyz.Add(new Variable(parser.Intern("Y")));
+	xyz.Add(new Variable(parser.Intern("Z")));
+	NodeVar x = xyz[0], y = xyz[1], z = xyz[2];
+
+	Vector<NodeVar> vars;
+	vars.Add(x);
+	problem.axioms.Add(CloseAll(vars, Equation(parser, x, x)));
+	vars.Add(y);
+	problem.axioms.Add(CloseAll(vars, new Implies(*Equation(parser, x, y), *Equation(parser, y, x))));
+	NodeVar xy_yz = new And(*Equation(parser, x, y), *Equation(parser, y, z));
+	problem.axioms.Add(CloseAll(xyz, new Implies(*xy_yz, *Equation(parser, x, z))));
+
+	for(int i = 0; i < sig.names.GetCount(); i++) {
+		int arity = sig.arity[i];
+		if (sig.predicate[i] && sig.names[i] == "=")
+			continue;
+
+		Vector<NodeVar> args;
+		for(int j = 0; j < arity; j++)
+			args.Add(new Variable(parser.Intern("A" + IntStr(j + 1))));
+
+		for(int j = 0; j < arity; j++) {
+			Index<NodeVar> left, right;
+			for(int k = 0; k < arity; k++) {
+				left.Add(k == j ? x : args[k]);
+				right.Add(k == j ? y : args[k]);
+			}
+			Vector<NodeVar> closed;
+			closed.Add(x);
+			closed.Add(y);
+			for(int k = 0; k < arity; k++)
+				if (k != j)
+					closed.Add(args[k]);
+
+			NodeVar formula;
+			if (sig.predicate[i]) {
+				NodeVar premise = new And(*Equation(parser, x, y), *NodeVar(new Predicate(sig.names[i], left)));
+				formula = new Implies(*premise, *NodeVar(new Predicate(sig.names[i], right)));
+			}
+			else
+				formula = new Implies(*Equation(parser, x, y),
+				                      *Equation(parser, new Function(sig.names[i], left), new Function(sig.names[i], right)));
+			problem.axioms.Add(CloseAll(closed, formula));
+		}
+	}
+}
+
+static void AddTptpFormula(TptpProblem& problem, Vector<NodeVar>& conjectures, const TptpFormula& f) {
+	problem.formulas++;
+	if (f.role == "conjecture" || f.role == "question")
+		conjectures.Add(f.formula);
+	else if (f.role != "type")
+		problem.axioms.Add(f.formula);
+}
+
+static void FinishTptp(TptpParser& parser, TptpProblem& problem, Vector<NodeVar>& conjectures) {
+	if (parser.UsesTrue())
+		problem.axioms.Add(new Predicate(parser.Intern("$true"), Index<NodeVar>()));
+	if (parser.UsesFalse())
+		problem.axioms.Add(new Not(*NodeVar(new Predicate(parser.Intern("$false"), Index<NodeVar>()))));
+
+	if (parser.UsesEquality())
+		AddEqualityAxioms(parser, problem, conjectures);
+
+	problem.conjectures = conjectures.GetCount();
+
+	// without a conjecture the problem is to show that the axioms are contradictory
+	if (conjectures.IsEmpty()) {
+		problem.goal = new Predicate(parser.Intern("$false"), Index<NodeVar>());
+		return;
+	}
+
+	problem.goal = conjectures[0];
+	for(int i = 1; i < conjectures.GetCount(); i++)
+		problem.goal = new And(*problem.goal, *conjectures[i]);
+}
+
+void LoadTptp(Stream& in, const String& source, TptpProblem& problem) {
+	TptpParser parser;
+	Vector<NodeVar> conjectures;
+	parser.WhenFormula = [&](const TptpFormula& f) {AddTptpFormula(problem, conjectures, f);};
+	parser.Parse(in, source);
+	FinishTptp(parser, problem, conjectures);
+}
+
+void LoadTptpFile(const String& path, TptpProblem& problem) {
+	TptpParser parser;
+	Vector<NodeVar> conjectures;
+	parser.WhenFormula = [&](const TptpFormula& f) {AddTptpFormula(problem, conjectures, f);};
+	parser.ParseFile(path);
+	FinishTptp(parser, problem, conjectures);
+}
+
+}
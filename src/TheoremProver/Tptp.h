@@ -0,0 +1,113 @@
+#ifndef _TheoremProver_Tptp_h_
+#define _TheoremProver_Tptp_h_
+
+namespace TheoremProver {
+
+/*
+	TPTP front-end.
+
+	Reads fof and cnf annotated formulas and include directives from a
+	stream through a fixed size buffer and builds the Node trees directly,
+	without going through TokenList and Parse. Every formula is handed to
+	WhenFormula as soon as its closing "." is read, so memory stays bounded
+	by the largest formula plus the symbol table, whatever the size of the
+	axiom files. Symbol names are interned, so the nodes of all formulas
+	share one copy of each name.
+
+	Variables are the upper case words of TPTP, functions and predicates
+	are the lower case words, quoted atoms, numbers and distinct objects.
+	Free variables of cnf clauses are closed universally. Equality is the
+	predicate "=": when it occurs, the problem gets the axioms of equality
+	(reflexivity, symmetry, transitivity and congruence for every function
+	and predicate symbol). $true and $false are the predicates "$true" and
+	"$false" with the axioms "$true" and "~$false".
+*/
+
+struct TptpFormula {
+	String  name;
+	String  role;
+	bool    cnf;
+	NodeVar formula;
+};
+
+class TptpParser {
+	struct Input {
+		Stream*       in;
+		String        source;
+		Buffer<char>  buffer;
+		int           pos, len;
+		int           line;
+		bool          eof;
+	};
+
+	enum {
+		TK_EOF,
+		TK_WORD,      // functor, predicate or quoted atom
+		TK_VARIABLE,
+		TK_DEFINED,   // $word
+		TK_PUNCT
+	};
+
+	Input input;
+	int tk;
+	String token;
+
+	Index<String> symbols;
+	Index<String> include_dirs;
+	int include_depth;
+	bool uses_true, uses_false, uses_equality;
+
+	int  Peek();
+	int  Get();
+	void Fill();
+	void SkipSpace();
+	void Next();
+	bool Is(const char* punct) const {return tk == TK_PUNCT && token == punct;}
+	void Expect(const char* punct);
+	String ReadName();
+	void SkipAnnotation();
+	void Error(const String& msg) const;
+
+	NodeVar ParseFormula();
+	NodeVar ParseUnitary();
+	NodeVar ParseAtom();
+	NodeVar ParseTerm();
+	void    ParseArgs(Index<NodeVar>& args);
+	NodeVar Close(NodeVar formula);
+
+	void ParseInput(const Index<String>* selection);
+	void ParseInclude();
+	void ParseFile(const String& path, const Index<String>* selection);
+
+public:
+	Callback1<const TptpFormula&> WhenFormula;
+
+	TptpParser();
+
+	void AddIncludeDir(const String& dir) {include_dirs.FindAdd(dir);}
+	void Parse(Stream& in, const String& source);
+	void ParseFile(const String& path) {ParseFile(path, NULL);}
+
+	const String& Intern(const String& name) {return symbols[symbols.FindAdd(name)];}
+	int GetSymbolCount() const {return symbols.GetCount();}
+	bool UsesTrue() const {return uses_true;}
+	bool UsesFalse() const {return uses_false;}
+	bool UsesEquality() const {return uses_equality;}
+
+};
+
+struct TptpProblem {
+	Index<NodeVar> axioms;
+	NodeVar        goal;
+	int            formulas;
+	int            conjectures;
+
+	TptpProblem() : formulas(0), conjectures(0) {}
+};
+
+void LoadTptp(Stream& in, const String& source, TptpProblem& problem);
+void LoadTptpFile(const String& path, TptpProblem& problem);
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+static const char* trace_level_names[] = {"off", "summary", "steps", "debug"};
+
+int GetTraceLevel() {
+	return GetSession().GetTraceLevel();
+}
+
+void SetTraceLevel(int level) {
+	GetSession().SetTraceLevel(min(max(level, (int)TRACE_OFF), TRACE_MAX_LEVEL));
+}
+
+void SetTraceSink(TraceSink* sink) {
+	GetSession().SetTraceSink(sink);
+}
+
+TraceSink& GetTraceSink() {
+	static LogTraceSink log;
+	TraceSink* sink = GetSession().GetTraceSink();
+	return sink ? *sink : log;
+}
+
+void Trace(int level, const String& msg) {
+	GetTraceSink().Put(level, msg);
+}
+
+String GetTraceLevelName(int level) {
+	if (level < TRACE_OFF || level > TRACE_DEBUG)
+		return "";
+	return trace_level_names[level];
+}
+
+int FindTraceLevel(const String& name) {
+	for(int i = TRACE_OFF; i <= TRACE_DEBUG; i++)
+		if (name == trace_level_names[i])
+			return i;
+	return -1;
+}
+
+}
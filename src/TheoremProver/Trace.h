@@ -0,0 +1,92 @@
+#ifndef _TheoremProver_Trace_h_
+#define _TheoremProver_Trace_h_
+
+namespace TheoremProver {
+
+/*
+	Tracing of the proof search.
+
+	Every message has a level and goes to the installed TraceSink. The level
+	and the sink belong to the ProverSession of the calling thread, so
+	sessions on other threads trace independently. The level is chosen at
+	run time with SetTraceLevel, but levels above
+	TRACE_MAX_LEVEL are removed by the preprocessor together with the code
+	which formats the message. Release builds keep only the summary level,
+	so the search loops do no string work unless a debug build asks for it.
+*/
+
+enum {
+	TRACE_OFF,
+	TRACE_SUMMARY,
+	TRACE_STEPS,
+	TRACE_DEBUG
+};
+
+#ifndef TRACE_MAX_LEVEL
+	#ifdef flagDEBUG
+		#define TRACE_MAX_LEVEL 3
+	#else
+		#define TRACE_MAX_LEVEL 1
+	#endif
+#endif
+
+class TraceSink {
+
+public:
+	virtual ~TraceSink() {}
+	virtual void Put(int level, const String& msg) = 0;
+
+};
+
+class LogTraceSink : public TraceSink {
+
+public:
+	virtual void Put(int level, const String& msg) {LOG(msg);}
+
+};
+
+// the level of a message is already filtered when it reaches the sink
+class CallbackTraceSink : public TraceSink {
+
+public:
+	Callback1<String> WhenTrace;
+
+	CallbackTraceSink() {}
+	CallbackTraceSink(Callback1<String> cb) : WhenTrace(cb) {}
+	virtual void Put(int level, const String& msg) {if (WhenTrace) WhenTrace(msg);}
+
+};
+
+// of the session of the calling thread
+int GetTraceLevel();
+void SetTraceLevel(int level);
+void SetTraceSink(TraceSink* sink);
+TraceSink& GetTraceSink();
+void Trace(int level, const String& msg);
+
+String GetTraceLevelName(int level);
+int FindTraceLevel(const String& name);
+
+}
+
+#define TRACE_AT(level, x) do {if (TheoremProver::GetTraceLevel() >= (level)) TheoremProver::Trace(level, x);} while (0)
+
+#if TRACE_MAX_LEVEL >= 1
+	#define TRACESUMMARY(x) TRACE_AT(TheoremProver::TRACE_SUMMARY, x)
+#else
+	#define TRACESUMMARY(x)
+#endif
+
+#if TRACE_MAX_LEVEL >= 2
+	#define TRACESTEP(x) TRACE_AT(TheoremProver::TRACE_STEPS, x)
+#else
+	#define TRACESTEP(x)
+#endif
+
+#if TRACE_MAX_LEVEL >= 3
+	#define TRACEDEBUG(x) TRACE_AT(TheoremProver::TRACE_DEBUG, x)
+#else
+	#define TRACEDEBUG(x)
+#endif
+
+#endif
@@ -0,0 +1,229 @@
+#include "TheoremProver.h"
+
+namespace TheoremProver {
+
+GroundTermIndex::GroundTermIndex(const Var<GroundTermIndex>& base)
+	: Ref<GroundTermIndex>(TheoremProver::GetContext()) {
+	if (base.Is() && base->depth >= MAX_DEPTH)
+		this->base << base->GetFlat();
+	else
+		this->base << base;
+	count = base.Is() ? base->count : 0;
+	depth = this->base.Is() ? this->base->depth + 1 : 1;
+}
+
+void GroundTermIndex::GetReferences(Vector<RefBase*>& out) {
+	out.Add(base.GetNode());
+	out.Add(flat.GetNode());
+	for(int i = 0; i < terms.GetCount(); i++)
+		for(int j = 0; j < terms[i].GetCount(); j++)
+			out.Add(terms[i][j].GetNode());
+	for(int i = 0; i < seen.GetCount(); i++)
+		out.Add(seen[i].GetNode());
+	for(int i = 0; i < formulas.GetCount(); i++)
+		out.Add(formulas[i].GetNode());
+}
+
+bool GroundTermIndex::IsGround(Node& n) {
+	if (dynamic_cast<UnificationTerm*>(&n))
+		return false;
+
+	// free variables left in the sequent are eigenvariables, so they behave as constants
+	if (dynamic_cast<Variable*>(&n))
+		return true;
+
+	if (!dynamic_cast<Function*>(&n) && !dynamic_cast<Predicate*>(&n))
+		return false;
+
+	for(int i = 0; i < n.GetCount(); i++)
+		if (!IsGround(n[i]))
+			return false;
+	return true;
+}
+
+void GroundTermIndex::AddTerm(const NodeVar& term) {
+	if (!dynamic_cast<Function*>(&*term) && !dynamic_cast<Predicate*>(&*term))
+		return;
+
+	if (IsGround(*term)) {
+		if (HasTerm(term))
+			return;
+		seen.Add(term);
+		terms.GetAdd(term->GetSymbol()).Add(term);
+		count++;
+	}
+
+	for(int i = 0; i < term->GetCount(); i++)
+		AddTerm(NodeVar(&(*term)[i]));
+}
+
+void GroundTermIndex::AddFormula(const NodeVar& formula) {
+	// bound variables make everything below a quantifier non-ground
+	if (dynamic_cast<ForAll*>(&*formula) || dynamic_cast<ThereExists*>(&*formula))
+		return;
+
+	// the formulas of the parent sequent are in the layers below
+	if (HasFormula(formula))
+		return;
+	formulas.Add(formula);
+
+	if (dynamic_cast<Predicate*>(&*formula)) {
+		AddTerm(formula);
+		return;
+	}
+
+	for(int i = 0; i < formula->GetCount(); i++)
+		AddFormula(NodeVar(&(*formula)[i]));
+}
+
+// the layers of a chain don't share terms or formulas, so they are appended as they are
+void GroundTermIndex::Merge(const GroundTermIndex& src) {
+	for(int i = 0; i < src.terms.GetCount(); i++)
+		terms.GetAdd(src.terms.GetKey(i)).Append(src.terms[i]);
+	for(int i = 0; i < src.seen.GetCount(); i++)
+		seen.Add(src.seen[i]);
+	for(int i = 0; i < src.formulas.GetCount(); i++)
+		formulas.Add(src.formulas[i]);
+	count += src.seen.GetCount();
+}
+
+const Var<GroundTermIndex>& GroundTermIndex::GetFlat() const {
+	if (!flat.Is()) {
+		flat = new GroundTermIndex(Var<GroundTermIndex>());
+		for(const GroundTermIndex* g = this; g; g = g->base.GetNode())
+			flat->Merge(*g);
+	}
+	return flat;
+}
+
+bool GroundTermIndex::HasTerm(const NodeVar& term) const {
+	for(const GroundTermIndex* g = this; g; g = g->base.GetNode())
+		if (g->seen.Find(term) != -1)
+			return true;
+	return false;
+}
+
+bool GroundTermIndex::HasFormula(const NodeVar& formula) const {
+	for(const GroundTermIndex* g = this; g; g = g->base.GetNode())
+		if (g->formulas.Find(formula) != -1)
+			return true;
+	return false;
+}
+
+void GroundTermIndex::Find(int symbol, Vector<const Vector<NodeVar>*>& out) const {
+	for(const GroundTermIndex* g = this; g; g = g->base.GetNode()) {
+		int i = g->terms.Find(symbol);
+		if (i != -1)
+			out.Add(&g->terms[i]);
+	}
+}
+
+
+// Trigger inference
+
+enum {
+	HAS_VARIABLE = 1,
+	HAS_BOUND = 2
+};
+
+// returns HAS_* flags of the subtree and adds the smallest terms, which contain the
+// quantified variable but no variable bound inside the body, to the triggers
+static int ScanTriggers(Node& n, const String& var, Index<String>& bound, Vector<NodeVar>& triggers) {
+	if (dynamic_cast<Variable*>(&n)) {
+		if (n.GetName() == var)
+			return HAS_VARIABLE;
+		if (bound.Find(n.GetName()) != -1)
+			return HAS_BOUND;
+		return 0;
+	}
+
+	if (dynamic_cast<UnificationTerm*>(&n))
+		return 0;
+
+	if (dynamic_cast<ForAll*>(&n) || dynamic_cast<ThereExists*>(&n)) {
+		String inner = n[0].GetName();
+
+		// shadowed: the quantified variable doesn't occur below
+		if (inner == var)
+			return 0;
+
+		bound.Add(inner);
+		int flags = ScanTriggers(n[1], var, bound, triggers);
+		bound.Remove(bound.GetCount() - 1);
+		return flags;
+	}
+
+	int count = triggers.GetCount();
+	int flags = 0;
+	for(int i = 0; i < n.GetCount(); i++)
+		flags |= ScanTriggers(n[i], var, bound, triggers);
+
+	bool is_term = dynamic_cast<Function*>(&n) || dynamic_cast<Predicate*>(&n);
+	if (is_term && flags == HAS_VARIABLE && triggers.GetCount() == count)
+		triggers.Add(&n);
+
+	return flags;
+}
+
+void InferTriggers(Node& variable, Node& body, Vector<NodeVar>& triggers) {
+	Index<String> bound;
+	ScanTriggers(body, variable.GetName(), bound, triggers);
+}
+
+
+// E-matching
+
+bool MatchTrigger(Node& pattern, Node& ground, Node& variable, NodeVar& binding) {
+	if (dynamic_cast<Variable*>(&pattern)) {
+		if (pattern.GetName() == variable.GetName()) {
+			NodeVar value(&ground);
+			if (binding.Is())
+				return binding == value;
+			binding = value;
+			return true;
+		}
+		return dynamic_cast<Variable*>(&ground) && ground.GetName() == pattern.GetName();
+	}
+
+	bool is_fn = dynamic_cast<Function*>(&pattern);
+	bool is_pred = dynamic_cast<Predicate*>(&pattern);
+	if (!is_fn && !is_pred)
+		return false;
+
+	if (is_fn != (dynamic_cast<Function*>(&ground) != NULL) ||
+		is_pred != (dynamic_cast<Predicate*>(&ground) != NULL))
+		return false;
+
+	if (pattern.GetName() != ground.GetName() || pattern.GetCount() != ground.GetCount())
+		return false;
+
+	for(int i = 0; i < pattern.GetCount(); i++)
+		if (!MatchTrigger(pattern[i], ground[i], variable, binding))
+			return false;
+
+	return true;
+}
+
+void EMatch(Node& variable, Node& body, const GroundTermIndex& index, Index<NodeVar>& instances) {
+	Vector<NodeVar> triggers;
+	InferTriggers(variable, body, triggers);
+
+	Vector<const Vector<NodeVar>*> layers;
+	for(int i = 0; i < triggers.GetCount(); i++) {
+		Node& pattern = *triggers[i];
+		layers.SetCount(0);
+		index.Find(pattern.GetSymbol(), layers);
+
+		for(int l = 0; l < layers.GetCount(); l++) {
+			const Vector<NodeVar>& candidates = *layers[l];
+			for(int j = 0; j < candidates.GetCount(); j++) {
+				NodeVar binding;
+				if (MatchTrigger(pattern, *candidates[j], variable, binding) &&
+					binding.Is() && instances.Find(binding) == -1)
+					instances.Add(binding);
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef _TheoremProver_Trigger_h_
+#define _TheoremProver_Trigger_h_
+
+namespace TheoremProver {
+
+/*
+	Trigger based instantiation of universally quantified formulas.
+
+	Instead of instantiating "forall x. P" with a fresh unification term, the
+	prover can match trigger patterns of P (subterms containing x) against the
+	ground terms that actually occur in the sequent (E-matching). The ground
+	terms are kept in an inverted index keyed by the interned id of the head
+	symbol, so only terms that can possibly match a pattern are visited.
+
+	The index is kept per sequent, as a layer of the terms of the formulas
+	new in the sequent over the index of its parent, and the layers are
+	shared by the sequents of a branch. A term stays in the index of the
+	branch after a rule drops the formula it was in, which is sound, as it
+	is still a term of the branch.
+
+	A lookup visits every layer of the chain, so a chain is not let grow
+	past MAX_DEPTH layers: a layer over a full chain is put over one layer
+	with all of its terms merged instead. The merged layer is made once per
+	chain and shared by every layer put over it.
+*/
+
+class GroundTermIndex : public Ref<GroundTermIndex> {
+	Var<GroundTermIndex> base;
+	mutable Var<GroundTermIndex> flat;  // the chain merged in one layer, made on demand
+	VectorMap<int, Vector<NodeVar> > terms;
+	Index<NodeVar> seen;
+	Index<NodeVar> formulas;
+	int count;
+	int depth;  // layers of the chain, this one included
+
+	void AddTerm(const NodeVar& term);
+	void Merge(const GroundTermIndex& src);
+	const Var<GroundTermIndex>& GetFlat() const;
+
+public:
+	enum { MAX_DEPTH = 8 };
+
+	GroundTermIndex(const Var<GroundTermIndex>& base);
+
+	virtual void GetReferences(Vector<RefBase*>& out);
+
+	void AddFormula(const NodeVar& formula);
+	bool HasTerm(const NodeVar& term) const;
+	bool HasFormula(const NodeVar& formula) const;
+
+	void Find(int symbol, Vector<const Vector<NodeVar>*>& out) const;
+	int GetCount() const {return count;}
+	int GetDepth() const {return depth;}
+
+	static bool IsGround(Node& n);
+
+};
+
+typedef Var<GroundTermIndex> GroundTermIndexVar;
+
+void InferTriggers(Node& variable, Node& body, Vector<NodeVar>& triggers);
+bool MatchTrigger(Node& pattern, Node& ground, Node& variable, NodeVar& binding);
+void EMatch(Node& variable, Node& body, const GroundTermIndex& index, Index<NodeVar>& instances);
+
+}
+
+#endif